@@ -0,0 +1,163 @@
+/*! \file binlink.c \brief Binary frames on the PC link. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'binlink.c'
+// Title		: Binary PC link
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    Timer2 (through timebase.c)
+
+// Frames share UART1 with the text console. A frame is
+//   BIN_SYNC, opcode, length (low, high), payload, checksum
+// and the checksum makes the bytes from the opcode on add up to zero.
+// Multi byte values in the payload are little endian.
+//
+// BIN_SYNC is not printable, so the console never sees it in typed text;
+// once it arrives every byte goes here until the frame is complete. A frame
+// that stalls for more than BIN_TIMEOUT_MS is dropped and the console gets
+// the line back.
+//
+// binlink_rx() only follows the framing and runs from the UART1 Rx
+// interrupt; the caller keeps the opcode, length and payload bytes (the
+// ones it gets BIN_BUSY for).
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include <p33FJ128MC802.h>
+#include "binlink.h"
+#include "timebase.h"
+
+
+#define BIN_TIMEOUT_MS 20
+
+
+enum { RX_IDLE, RX_OP, RX_LEN_LO, RX_LEN_HI, RX_DATA, RX_SUM };
+
+int rxState = RX_IDLE;
+unsigned int rxLen;
+unsigned int rxCount;
+unsigned char rxSum;
+unsigned long rxLast;				// Time stamp of the last byte
+
+void (*linkPut)(unsigned char);		// Byte out to UART1
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// 'put' sends one byte to the PC
+void binlink_init(void (*put)(unsigned char))
+{
+	linkPut = put;
+	rxState = RX_IDLE;
+}
+
+
+// Feed one byte from UART1. Returns BIN_NONE if it belongs to the console.
+// A frame in progress is abandoned (without BIN_DROP) if it stalled.
+int binlink_rx(unsigned char data)
+{
+	unsigned long now = tb_now();
+	int result = BIN_BUSY;
+
+	if(rxState != RX_IDLE && now - rxLast > BIN_TIMEOUT_MS*1000UL*TB_PER_US)
+		rxState = RX_IDLE;			// Stalled frame, start over
+	rxLast = now;
+
+	switch(rxState)
+	{
+		case RX_IDLE:
+			if(data != BIN_SYNC)
+				return BIN_NONE;
+			rxSum = 0;
+			rxState = RX_OP;
+			return BIN_HEAD;			// Sync is not part of the checksum
+
+		case RX_OP:
+			rxState = RX_LEN_LO;
+			break;
+
+		case RX_LEN_LO:
+			rxLen = data;
+			rxState = RX_LEN_HI;
+			break;
+
+		case RX_LEN_HI:
+			rxLen |= (unsigned int)data << 8;
+			rxCount = 0;
+			if(rxLen > BIN_MAX_LEN)		// Can't be ours, back to the console
+			{
+				rxState = RX_IDLE;
+				result = BIN_DROP;
+			}
+			else
+				rxState = rxLen ? RX_DATA : RX_SUM;
+			break;
+
+		case RX_DATA:
+			if(++rxCount == rxLen)
+				rxState = RX_SUM;
+			break;
+
+		case RX_SUM:
+			rxState = RX_IDLE;
+			return ((unsigned char)(rxSum + data) == 0) ? BIN_FRAME : BIN_BAD;
+	}
+	rxSum += data;
+	return result;
+}
+
+
+// Frame header, returns the checksum so far
+static unsigned char link_head(unsigned char op, unsigned int len)
+{
+	linkPut(BIN_SYNC);
+	linkPut(op);
+	linkPut(len & 0xFF);
+	linkPut(len >> 8);
+	return op + (len & 0xFF) + (len >> 8);
+}
+
+
+// Send a frame with 'len' bytes of payload
+void binlink_send(unsigned char op, const unsigned char *data, unsigned int len)
+{
+	unsigned char sum = link_head(op, len);
+
+	while(len--)
+	{
+		sum += *data;
+		linkPut(*data++);
+	}
+	linkPut(-sum);
+}
+
+
+// Same, with a 16 bit value in front of the payload (e.g. an address)
+void binlink_send2(unsigned char op, unsigned int word, const unsigned char *data, unsigned int len)
+{
+	unsigned char sum = link_head(op, len+2);
+
+	linkPut(word & 0xFF);
+	linkPut(word >> 8);
+	sum += (word & 0xFF) + (word >> 8);
+	while(len--)
+	{
+		sum += *data;
+		linkPut(*data++);
+	}
+	linkPut(-sum);
+}
@@ -0,0 +1,52 @@
+/*! \file binlink.h \brief Binary frames on the PC link. */
+//*****************************************************************************
+//
+// File Name	: 'binlink.h'
+// Title		: Binary PC link
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __BINLINK_H__
+ #define __BINLINK_H__
+
+
+#define BIN_SYNC 0xA5				// First byte of a frame, never typed on the console
+#define BIN_MAX_LEN 514				// Longest payload (address and 512 slots)
+
+// Opcodes (PC -> Controller). Replies carry the opcode with bit 7 set.
+#define BIN_UNIVERSE 0x01			// Slots 1..n (1-512 bytes)
+#define BIN_WRITE 0x02				// Address (2 bytes) then slot values
+#define BIN_READ 0x03				// Address, count (2 bytes each). Reply: address then values
+#define BIN_COMMIT 0x04				// Send staged changes (after 'auto 0')
+#define BIN_MAX 0x05				// Frame length (2 bytes), 0 = auto, as 'max'
+#define BIN_ERROR 0x7F				// Reply only: opcode, error code
+#define BIN_REPLY 0x80
+
+// Error codes
+#define BIN_ERR_CHECKSUM 1
+#define BIN_ERR_OPCODE 2
+#define BIN_ERR_RANGE 3
+
+// binlink_rx() results
+#define BIN_NONE 0					// Byte is not part of a frame
+#define BIN_HEAD 1					// Sync, a frame starts
+#define BIN_BUSY 2					// Opcode, length or payload byte
+#define BIN_FRAME 3					// Checksum, frame is valid
+#define BIN_BAD 4					// Checksum, frame is not valid
+#define BIN_DROP 5					// Length out of range, frame dropped
+
+// 16 bit value in a frame (little endian)
+#define BIN_WORD(p) ((p)[0] | ((unsigned int)(p)[1] << 8))
+
+
+//Functions
+void binlink_init(void (*put)(unsigned char));
+int binlink_rx(unsigned char data);
+void binlink_send(unsigned char op, const unsigned char *data, unsigned int len);
+void binlink_send2(unsigned char op, unsigned int word, const unsigned char *data, unsigned int len);
+
+#endif
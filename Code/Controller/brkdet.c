@@ -0,0 +1,172 @@
+/*! \file brkdet.c \brief Break detector on the DMX receive line. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'brkdet.c'
+// Title		: Break detector
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    Input Capture 1 on RP7 (U2RX pin), Timer2 (through timebase.c)
+
+// Watches the receive line while the Controller listens for a POLL answer.
+// IC1 time stamps every edge with Timer2, the time stamp timer of
+// timebase.c (0.2 us). The line idles high, so the edges alternate starting
+// with a falling one.
+//
+// A low of at least BRKDET_MIN_US is a Break: someone answered. Shorter ones
+// are glitches; they are counted and otherwise ignored. If no low started
+// within BRKDET_TURN_US after brkdet_arm() (or after the last glitch),
+// nobody answers and the listen window closes at once. A line still low or
+// restless BRKDET_STUCK_US after brkdet_arm() is no answer either; it is
+// counted on its own, as a fault of the bus rather than a glitch.
+// After the Break, brkdet_idle() tells when the line has been high long
+// enough for the answer to be over.
+//
+// Only 16 bits of Timer2 are used: every time measured here is far below
+// the 13 ms it takes to wrap.
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include <p33FJ128MC802.h>
+#include "brkdet.h"
+#include "timebase.h"
+
+
+#define RP_U2RX 7					// U2RX pin (RP7), see init_hw()
+
+#define TICKS(us) ((unsigned int)(us)*TB_PER_US)
+#define SINCE(t, t0) (((t) - (t0)) & 0xFFFF)	// Ticks between two Timer2 stamps
+
+
+volatile unsigned int edges;		// Edges since brkdet_arm(); odd: line is low
+volatile unsigned int edgeFall;		// Time stamp of the last falling edge
+volatile unsigned int edgeLast;		// Time stamp of the last edge
+volatile int brkSeen;				// A Break came since brkdet_arm()
+unsigned int armAt;					// Time stamp of brkdet_arm()
+unsigned int brkLen;				// Length of the last Break, in ticks
+volatile unsigned int glitches = 0;	// Lows too short for a Break, since power up
+unsigned int stuck = 0;				// Listen windows given up on a low or restless line
+
+
+//-----------------------------------------------------------------------------
+// Interrupt Subroutines
+//-----------------------------------------------------------------------------
+
+// For IC1 (edge on U2RX)
+void __attribute__((interrupt, no_auto_psv)) _IC1Interrupt(void)
+{
+	unsigned int t;
+
+	IFS0bits.IC1IF = 0;				// Clear the flag first, the buffer is emptied below
+	while(IC1CONbits.ICBNE)
+	{
+		t = IC1BUF;
+		if(!(edges & 1))			// Line was high: falling edge
+			edgeFall = t;
+		else if(!brkSeen)			// Rising edge: how long was it low?
+		{
+			if(SINCE(t, edgeFall) >= TICKS(BRKDET_MIN_US))
+			{
+				brkLen = SINCE(t, edgeFall);
+				brkSeen = 1;
+			}
+			else
+				glitches++;
+		}
+		edgeLast = t;
+		edges++;
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void brkdet_init(void)
+{
+	RPINR7bits.IC1R = RP_U2RX;		// IC1 listens on the U2RX pin too
+	IC1CON = 0;						// Off
+	IC1CONbits.ICTMR = 1;			// Time stamps from Timer2
+	IFS0bits.IC1IF = 0;				// Clear the flag
+	IEC0bits.IC1IE = 0;
+}
+
+
+// Start listening. Our last stop bit must be out, the line released.
+void brkdet_arm(void)
+{
+	IC1CONbits.ICM = 0;
+	while(IC1CONbits.ICBNE)			// Nothing old in the buffer
+		edgeLast = IC1BUF;
+	edges = 0;
+	brkSeen = 0;
+	armAt = TMR2;
+	IFS0bits.IC1IF = 0;
+	IEC0bits.IC1IE = 1;
+	IC1CONbits.ICM = 1;				// Capture every edge
+}
+
+
+// Has someone answered? BRKDET_WAIT while it can't be told yet.
+int brkdet_check(void)
+{
+	unsigned int now = TMR2;
+
+	if(brkSeen)
+		return BRKDET_BREAK;
+	if(SINCE(now, armAt) >= TICKS(BRKDET_STUCK_US))
+	{
+		stuck++;					// Held low or never settles, nobody talks like that
+		return BRKDET_QUIET;
+	}
+	if(IC1CONbits.ICBNE || (edges & 1))	// Edge not handled yet, or low: Break or not?
+		return BRKDET_WAIT;
+	if(SINCE(now, armAt) < TICKS(BRKDET_TURN_US) || (edges && SINCE(now, edgeLast) < TICKS(BRKDET_TURN_US)))
+		return BRKDET_WAIT;			// A glitch may come just before the Break
+	return BRKDET_QUIET;
+}
+
+
+// Line has been high for a while after the last edge
+int brkdet_idle(void)
+{
+	return !(edges & 1) && !IC1CONbits.ICBNE && SINCE(TMR2, edgeLast) >= TICKS(BRKDET_IDLE_US);
+}
+
+
+void brkdet_stop(void)
+{
+	IEC0bits.IC1IE = 0;
+	IC1CONbits.ICM = 0;				// Off
+}
+
+
+// Length of the last Break in us
+unsigned int brkdet_brkUs(void)
+{
+	return brkLen/TB_PER_US;
+}
+
+
+unsigned int brkdet_glitches(void)
+{
+	return glitches;
+}
+
+
+unsigned int brkdet_stuck(void)
+{
+	return stuck;
+}
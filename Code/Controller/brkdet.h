@@ -0,0 +1,37 @@
+/*! \file brkdet.h \brief Break detector on the DMX receive line. */
+//*****************************************************************************
+//
+// File Name	: 'brkdet.h'
+// Title		: Break detector
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __BRKDET_H__
+ #define __BRKDET_H__
+
+
+#define BRKDET_MIN_US 88			// Shortest low taken as a Break (E1.11 receiver minimum)
+#define BRKDET_TURN_US 30			// An answer starts this soon after our last stop bit
+#define BRKDET_IDLE_US 88			// High this long after the last edge: bus is free (2 slots)
+#define BRKDET_STUCK_US 2000		// No Break by then: a fault, not an answer
+
+#define BRKDET_WAIT 0				// brkdet_check() results
+#define BRKDET_QUIET 1
+#define BRKDET_BREAK 2
+
+
+//Functions
+void brkdet_init(void);
+void brkdet_arm(void);
+int brkdet_check(void);
+int brkdet_idle(void);
+void brkdet_stop(void);
+unsigned int brkdet_brkUs(void);
+unsigned int brkdet_glitches(void);
+unsigned int brkdet_stuck(void);
+
+#endif
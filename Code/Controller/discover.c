@@ -0,0 +1,305 @@
+/*! \file discover.c \brief Device discovery by bisecting the address space. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'discover.c'
+// Title		: Device discovery
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    Timer2 (through timebase.c)
+
+// Finds every Device address with the 'probe' function given to disc_init().
+// A probe asks all Devices from 'min' to 'max' which are not found yet to
+// answer. It returns DISC_QUIET, DISC_NOADDR if someone answered, or the
+// address the Devices sent after their Break (disc_decode()).
+//
+// An address is only taken after the Device answered a probe of just that
+// address (a collision can still look like an address). Then the same
+// range is probed again with that Device muted. A lone Device in a range
+// is so found with two probes; ranges are only split on a collision, or for
+// Devices which send no address.
+//
+// The address space is walked as a binary tree. Ranges still to be probed
+// are kept on a stack, so after a leaf the walk goes on with the last open
+// branch instead of starting again at 1..512: every range is probed once.
+// Two shortcuts: if the left half of a range which answered is quiet, the
+// right half is split without a probe. After a leaf, all open ranges
+// (everything right of it) are probed together first; if they are quiet
+// the stack is dropped at once, which keeps sparse rigs cheap.
+// When the stack is empty the whole range is probed once more with all
+// found addresses muted. An answer means a Device was missed (e.g. it came
+// up during the walk) and starts another walk, at most DISC_PASSES times.
+//
+// Found addresses are kept as a bit set over 1..512 (64 bytes), so every
+// address can be on the bus and the probe can mute them without a search.
+//
+// disc_step() does one probe, so the caller decides what happens between
+// them. Probes and the time spent in them are counted for 'poll'.
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include <string.h>
+#include "discover.h"
+#include "timebase.h"
+
+
+// Kinds of open ranges
+#define RANGE_OPEN 0				// Not probed yet
+#define RANGE_HIT 1					// Known to hold someone, split it without a probe
+#define RANGE_AGAIN 2				// Probed again after a Device in it was found
+#define RANGE_CHECK 3				// Address sent by a range, does it answer alone?
+
+
+unsigned int (*discProbe)(unsigned int min, unsigned int max);
+
+// Open ranges
+unsigned int stackMin[DISC_STACK];
+unsigned int stackMax[DISC_STACK];
+unsigned char stackKind[DISC_STACK];
+int discTop = 0;
+int discLeaf = 0;					// Last probe found a Device
+int discPasses;						// Whole range probes left
+
+// Results
+unsigned char discMap[64];			// Bit 'addr-1' set: found
+unsigned int discCount = 0;
+unsigned int discProbes = 0;
+unsigned long discTicks = 0;		// Time stamp ticks spent in probes
+unsigned long discWorst = 0;		// Longest probe
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void disc_init(unsigned int (*probe)(unsigned int min, unsigned int max))
+{
+	discProbe = probe;
+	discTop = 0;
+	discPasses = 0;
+	discCount = 0;
+	memset(discMap, 0, sizeof(discMap));
+}
+
+
+static void disc_add(unsigned int addr)
+{
+	if(disc_found(addr))
+		return;
+	addr--;
+	discMap[addr >> 3] |= 1 << (addr & 7);
+	discCount++;
+}
+
+
+static void disc_push(unsigned int min, unsigned int max, unsigned char kind)
+{
+	if(discTop < DISC_STACK)
+	{
+		stackMin[discTop] = min;
+		stackMax[discTop] = max;
+		stackKind[discTop] = kind;
+		discTop++;
+	}
+}
+
+
+static unsigned int disc_probe(unsigned int min, unsigned int max)
+{
+	unsigned long start = tb_now();
+	unsigned int answer = discProbe(min, max);
+
+	start = tb_now() - start;
+	discTicks += start;
+	if(start > discWorst)
+		discWorst = start;
+	discProbes++;
+	return answer;
+}
+
+
+// Forget the last results and start a new search
+void disc_start(void)
+{
+	memset(discMap, 0, sizeof(discMap));
+	discCount = 0;
+	discProbes = 0;
+	discTicks = 0;
+	discWorst = 0;
+	discTop = 0;
+	discLeaf = 0;
+	discPasses = DISC_PASSES;
+}
+
+
+// Probe the next range. Returns DISC_DONE once nothing is left to probe.
+int disc_step(void)
+{
+	unsigned int min, max, mid, answer;
+	unsigned char kind = RANGE_OPEN;
+
+	if(discLeaf && discTop > 1)		// Anyone right of the last Device?
+	{
+		discLeaf = 0;
+		if(disc_probe(stackMin[discTop-1], stackMax[0]) == DISC_QUIET)
+			discTop = 0;			// Open ranges are next to each other
+		return DISC_BUSY;
+	}
+	discLeaf = 0;
+
+	if(discTop)						// Next open range of the walk
+	{
+		discTop--;
+		min = stackMin[discTop];
+		max = stackMax[discTop];
+		kind = stackKind[discTop];
+	}
+	else if(discPasses)
+	{
+		discPasses--;				// Whole range, all found ones muted
+		min = 1;
+		max = 512;
+	}
+	else
+		return DISC_DONE;
+
+	if(kind == RANGE_HIT && min != max)	// A Device is always probed itself
+		answer = DISC_NOADDR;
+	else
+		answer = disc_probe(min, max);
+
+	if(kind == RANGE_CHECK)
+	{
+		if(answer != DISC_QUIET)
+			disc_add(min);			// It is there
+		else if(discTop)
+			stackKind[discTop-1] = RANGE_HIT;	// Made up by a collision, split the range
+	}
+	else if(answer == DISC_QUIET)
+	{
+		if(kind == RANGE_OPEN && discTop && stackKind[discTop-1] == RANGE_OPEN
+				&& stackMin[discTop-1] == max+1 && max-min == stackMax[discTop-1]-max-1)
+			stackKind[discTop-1] = RANGE_HIT;	// Quiet left half, so the right half answered
+		else if(min == 1 && max == 512)
+			discPasses = 0;			// Nobody left
+	}
+	else if(answer >= min && answer <= max && !disc_found(answer))
+	{
+		if(min == max)
+			disc_add(min);			// Leaf which told its own address
+		else
+		{
+			disc_push(min, max, RANGE_AGAIN);	// Rest of the range after this Device
+			disc_push(answer, answer, RANGE_CHECK);
+		}
+	}
+	else if(min == max)
+	{
+		disc_add(min);				// Leaf: one Device
+		discLeaf = 1;
+	}
+	else
+	{
+		mid = (min + max) >> 1;
+		disc_push(mid+1, max, RANGE_OPEN);	// Right half waits, left half next
+		disc_push(min, mid, RANGE_OPEN);
+	}
+	return DISC_BUSY;
+}
+
+
+// Complete search. Returns the number of Devices found.
+unsigned int disc_run(void)
+{
+	disc_start();
+	while(disc_step() == DISC_BUSY);
+	return discCount;
+}
+
+
+// Address in the answer to a probe, DISC_NOADDR if it can't be read
+unsigned int disc_decode(const unsigned char reply[], unsigned int len)
+{
+	unsigned int i, addr = 0, sum = 0, check = 0;
+
+	if(len < DISC_REPLY_LEN || reply[0] != DISC_SEPARATOR)
+		return DISC_NOADDR;
+	for(i=1;i<DISC_REPLY_LEN;i+=2)
+	{
+		if((reply[i] & 0xAA) != 0xAA || (reply[i+1] & 0x55) != 0x55)
+			return DISC_NOADDR;		// Not sent that way
+		if(i < 5)
+		{
+			addr = (addr << 8) | (reply[i] & reply[i+1]);
+			sum += reply[i] + reply[i+1];
+		}
+		else
+			check = (check << 8) | (reply[i] & reply[i+1]);
+	}
+	if(sum != check || addr < 1 || addr > 512)
+		return DISC_NOADDR;
+	return addr;
+}
+
+
+// Is 'addr' (1 to 512) one of the found Devices?
+int disc_found(unsigned int addr)
+{
+	addr--;
+	return (discMap[addr >> 3] >> (addr & 7)) & 1;
+}
+
+
+unsigned int disc_count(void)
+{
+	return discCount;
+}
+
+
+// First found address above 'addr' (0 for the lowest), 0 if there is none
+unsigned int disc_next(unsigned int addr)
+{
+	while(addr < 512)
+	{
+		if(!discMap[addr >> 3] && !(addr & 7))
+		{
+			addr += 8;				// Skip an empty byte
+			continue;
+		}
+		addr++;
+		if(disc_found(addr))
+			return addr;
+	}
+	return 0;
+}
+
+
+unsigned int disc_probes(void)
+{
+	return discProbes;
+}
+
+
+// Bus time of the last search
+unsigned long disc_busUs(void)
+{
+	return discTicks / TB_PER_US;
+}
+
+
+// Longest probe of the last search
+unsigned long disc_worstUs(void)
+{
+	return discWorst / TB_PER_US;
+}
@@ -0,0 +1,47 @@
+/*! \file discover.h \brief Device discovery by bisecting the address space. */
+//*****************************************************************************
+//
+// File Name	: 'discover.h'
+// Title		: Device discovery
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __DISCOVER_H__
+ #define __DISCOVER_H__
+
+
+#define DISC_STACK 12				// Open ranges: one per level of 1..512, the root, an address check
+#define DISC_PASSES 3				// Whole range probes that may restart the walk
+
+#define DISC_DONE 0					// disc_step() results
+#define DISC_BUSY 1
+
+#define DISC_QUIET 0				// Probe results, else the address of a lone Device
+#define DISC_NOADDR 0xFFFF			// Someone answered, address not readable
+
+// Answer of a Device after its Break: 0xAA, then address and checksum (high
+// bytes first), every byte sent twice, once OR 0xAA and once OR 0x55.
+// The checksum is the sum of the four address bytes on the wire. Like
+// RDM's DISC_UNIQUE_BRANCH answer, a collision spoils the checksum.
+#define DISC_SEPARATOR 0xAA
+#define DISC_REPLY_LEN 9
+
+
+//Functions
+void disc_init(unsigned int (*probe)(unsigned int min, unsigned int max));
+void disc_start(void);
+int disc_step(void);
+unsigned int disc_run(void);
+unsigned int disc_decode(const unsigned char reply[], unsigned int len);
+int disc_found(unsigned int addr);
+unsigned int disc_count(void);
+unsigned int disc_next(unsigned int addr);
+unsigned int disc_probes(void);
+unsigned long disc_busUs(void);
+unsigned long disc_worstUs(void);
+
+#endif
@@ -0,0 +1,278 @@
+/*! \file dmxsched.c \brief Constant rate DMX frame scheduler. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'dmxsched.c'
+// Title		: DMX frame scheduler
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    Timer4, Timer2 (through timebase.c)
+
+// Decides when dmxtx.c starts the next frame.
+//
+// Fixed rate: Timer4 ticks at the chosen rate and every tick starts a frame.
+// If the previous frame is still out, the next one starts as soon as it is
+// done (a late frame, it shows up in the jitter).
+// Rate 0: every frame starts right after the previous one. Timer4 only
+// retries in case nothing was committed yet.
+//
+// In both cases the Break waits for the mark before Break (MBB) after the
+// last stop bit, and for the E1.11 minimum of 1204 us Break to Break.
+//
+// dmxsched_hold() keeps the next frame back, e.g. while a POLL probe is on
+// the bus; dmxsched_release() starts it. A held frame counts as late.
+//
+// Jitter is the worst delay from a tick to the start of its Break, the rate
+// is counted over windows of about one second.
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include <p33FJ128MC802.h>
+#include "dmxsched.h"
+#include "dmxtx.h"
+#include "timebase.h"
+
+
+#define T4_PER_US_64 25				// Timer4 ticks per 40 us, prescaler 64
+#define T4_PER_S_64 625000UL		// Timer4 ticks per second, prescaler 64
+#define T4_PER_S_256 156250UL		// Timer4 ticks per second, prescaler 256
+#define WINDOW (1000000UL*TB_PER_US)	// Rate window, 1 s in time stamp ticks
+
+
+unsigned int schedRate = 0;			// Frames per second, 0 = back to back
+unsigned long schedMbb = 0;			// Mark before Break in time stamp ticks
+volatile int schedOn = 0;
+volatile int schedLate = 0;			// Tick came while the previous frame was out
+volatile int schedHold = 0;			// No new frames for now
+unsigned long schedTick;			// Time stamp of the last tick
+unsigned long schedEnd;				// Time stamp of the last frame end
+unsigned long schedBrk;				// Time stamp of the last Break
+
+// Statistics
+unsigned long statJitter = 0;		// Worst tick to Break delay
+unsigned int statFrames = 0;		// Frames in this window
+unsigned long statWinStart;
+unsigned int statRate10 = 0;		// Rate of the last window in 0.1 Hz
+int statRestart = 1;				// Next Break opens a new window
+
+
+//-----------------------------------------------------------------------------
+// Frame start (interrupt context)
+//-----------------------------------------------------------------------------
+
+// Start the next frame, keeping MBB and the minimum Break to Break time
+static void sched_kick(unsigned long now)
+{
+	unsigned long since, mark = 0;
+	unsigned long b2b = (unsigned long)B2B_MIN_US*TB_PER_US;
+
+	if(schedHold)
+	{
+		schedLate = 1;				// Started by dmxsched_release()
+		return;
+	}
+
+	since = now - schedEnd;
+	if(since < schedMbb)
+		mark = schedMbb - since;
+	since = now - schedBrk;
+	if(since < b2b && b2b - since > mark)
+		mark = b2b - since;
+
+	if(!dmxtx_start((mark + TB_PER_US - 1)/TB_PER_US))
+		return;
+	schedBrk = now + mark;
+
+	if(schedRate && schedBrk - schedTick > statJitter)
+		statJitter = schedBrk - schedTick;
+
+	if(statRestart)					// Window starts with a Break, not counted
+	{
+		statRestart = 0;
+		statFrames = 0;
+		statWinStart = schedBrk;
+		return;
+	}
+	statFrames++;
+	since = schedBrk - statWinStart;
+	if(since >= WINDOW)
+	{
+		statRate10 = (statFrames*10000UL)/(since/(1000UL*TB_PER_US));
+		statFrames = 0;
+		statWinStart = schedBrk;
+	}
+}
+
+
+// Frame is completely out (called from the UART2 Tx interrupt)
+static void sched_done(void)
+{
+	schedEnd = tb_now();
+	if(!schedOn)
+		return;
+	if(schedRate == 0 || schedLate)
+	{
+		schedLate = 0;
+		sched_kick(schedEnd);
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Interrupt Subroutines
+//-----------------------------------------------------------------------------
+
+// For TIMER4 (frame tick)
+void __attribute__((interrupt, no_auto_psv)) _T4Interrupt(void)
+{
+	schedTick = tb_now();
+	if(schedOn)
+	{
+		if(!dmxtx_busy())
+			sched_kick(schedTick);
+		else if(schedRate)
+			schedLate = 1;
+	}
+	IFS1bits.T4IF = 0;				// Clear the flag
+}
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void dmxsched_init(void)
+{
+	tb_init();
+	dmxtx_init(sched_done);
+
+	schedEnd = schedBrk = tb_now() - (unsigned long)B2B_MIN_US*TB_PER_US;	// Bus has been idle
+	T4CON = 0;						// Timer off, Fcy
+	IFS1bits.T4IF = 0;				// Clear the flag
+	IEC1bits.T4IE = 1;				// Enable timer 4 interrupts
+	dmxsched_setRate(0);
+}
+
+
+// Frames per second, RATE_MIN to RATE_MAX. 0 sends back to back.
+int dmxsched_setRate(unsigned int rate)
+{
+	if(rate != 0 && (rate < RATE_MIN || rate > RATE_MAX))
+		return 0;
+
+	T4CONbits.TON = 0;
+	schedRate = rate;
+	if(rate == 0)					// Only a retry tick
+	{
+		T4CONbits.TCKPS = 2;		// Prescaler 64
+		PR4 = (B2B_MIN_US/40)*T4_PER_US_64;
+	}
+	else if(rate < 10)
+	{
+		T4CONbits.TCKPS = 3;		// Prescaler 256
+		PR4 = T4_PER_S_256/rate - 1;
+	}
+	else
+	{
+		T4CONbits.TCKPS = 2;		// Prescaler 64
+		PR4 = T4_PER_S_64/rate - 1;
+	}
+	TMR4 = 0;
+	T4CONbits.TON = schedOn;
+	dmxsched_clearStats();
+	statRate10 = 0;					// New rate window
+	statRestart = 1;
+	return 1;
+}
+
+
+// Mark before Break in us, 0 to MBB_MAX_US
+int dmxsched_setMbb(unsigned int us)
+{
+	if(us > MBB_MAX_US)
+		return 0;
+	schedMbb = (unsigned long)us*TB_PER_US;
+	return 1;
+}
+
+
+void dmxsched_start(void)
+{
+	schedOn = 1;
+	statRestart = 1;
+	TMR4 = 0;
+	T4CONbits.TON = 1;
+	IFS1bits.T4IF = 1;				// First frame right away
+}
+
+
+// No new frames. The one on the wire is finished (check dmxtx_busy()).
+void dmxsched_stop(void)
+{
+	schedOn = 0;
+	T4CONbits.TON = 0;
+	schedLate = 0;
+	schedHold = 0;
+}
+
+
+// Keep the next frame back. The one on the wire is finished (check dmxtx_busy()).
+void dmxsched_hold(void)
+{
+	schedHold = 1;
+}
+
+
+// Frames go on after dmxsched_hold(), a held one starts now
+void dmxsched_release(void)
+{
+	int ipl;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);	// sched_kick() runs from interrupts
+	schedHold = 0;
+	if(schedOn && schedLate && !dmxtx_busy())
+	{
+		schedLate = 0;
+		sched_kick(tb_now());
+	}
+	RESTORE_CPU_IPL(ipl);
+}
+
+
+// Time since the last Break started, in us
+unsigned long dmxsched_sinceBrkUs(void)
+{
+	return (tb_now() - schedBrk)/TB_PER_US;
+}
+
+
+// Achieved rate in 0.1 Hz
+unsigned int dmxsched_rate10(void)
+{
+	return statRate10;
+}
+
+
+// Worst tick to Break delay in us since the last clear (fixed rate only)
+unsigned int dmxsched_jitterUs(void)
+{
+	return statJitter/TB_PER_US;
+}
+
+
+// Restart the worst case jitter
+void dmxsched_clearStats(void)
+{
+	statJitter = 0;
+}
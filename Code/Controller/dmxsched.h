@@ -0,0 +1,36 @@
+/*! \file dmxsched.h \brief Constant rate DMX frame scheduler. */
+//*****************************************************************************
+//
+// File Name	: 'dmxsched.h'
+// Title		: DMX frame scheduler
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __DMXSCHED_H__
+ #define __DMXSCHED_H__
+
+
+#define RATE_MIN 3					// Frames per second (0 = back to back)
+#define RATE_MAX 1000
+#define MBB_MAX_US 1000				// Mark before Break
+#define B2B_MIN_US 1204				// E1.11 minimum Break to Break time
+
+
+//Functions
+void dmxsched_init(void);
+int dmxsched_setRate(unsigned int rate);
+int dmxsched_setMbb(unsigned int us);
+void dmxsched_start(void);
+void dmxsched_stop(void);
+void dmxsched_hold(void);
+void dmxsched_release(void);
+unsigned long dmxsched_sinceBrkUs(void);
+unsigned int dmxsched_rate10(void);
+unsigned int dmxsched_jitterUs(void);
+void dmxsched_clearStats(void);
+
+#endif
@@ -0,0 +1,202 @@
+/*! \file dmxtx.c \brief DMA driven DMX frame transmitter. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'dmxtx.c'
+// Title		: DMX frame transmitter
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    UART2, DMA0, Timer3 (through dmxbrk.c)
+
+// Three 513 byte frame buffers live in DMA RAM, each one in a single role:
+//   front   - on the wire, DMA channel 0 feeds it into U2TXREG on every
+//             UART2 Tx request
+//   ready   - last committed frame, goes on the wire at the next start
+//   staging - belongs to the main loop, written with dmxtx_getBuf()
+// dmxtx_commit() swaps staging and ready, dmxtx_start() swaps ready and
+// front if something new was committed. Both are pointer swaps, so a frame
+// only ever shows a complete commit and never waits for a copy. Until the
+// next commit the frame on the wire is simply repeated.
+//
+// After a commit the new staging buffer is an older frame. Writers report
+// what they changed with dmxtx_mark(); each buffer keeps the range of slots
+// it is behind in, and only that range is copied when it becomes staging.
+//
+// A frame runs by itself from interrupts:
+//   dmxtx_start() -> mark, Break, MAB (Timer3) -> start code and slots (DMA0)
+//   -> UART2 Tx done (last stop bit out) -> 'done' function -> idle
+// dmxtx_start() may be called from interrupts. Index 0 of a buffer is the
+// start code.
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include <p33FJ128MC802.h>
+#include <string.h>
+#include "dmxtx.h"
+#include "dmxbrk.h"
+
+
+#define U2TX_IRQ 0x1F				// DMA request: UART2 transmitter
+
+
+// Frame buffers (must be in DMA RAM)
+unsigned char dmxBuf[3][513] __attribute__((space(dma)));
+unsigned int dmxBufSlots[3];		// Slots of the frame in each buffer
+
+unsigned int staleLo[3] = {513, 513, 513};	// Slots a buffer is behind staging in,
+unsigned int staleHi[3] = {0, 0, 0};		// none while Lo > Hi
+
+volatile int dmxFront = 0;			// Frame on the wire
+volatile int dmxReady = 1;			// Last committed frame
+int dmxStage = 2;					// Frame being prepared
+volatile int dmxNew = 0;			// Ready holds a frame not sent yet
+volatile int dmxTxBusy = 0;			// Frame in progress (mark to last stop bit)
+void (*dmxDone)(void);				// Called when a frame is completely out
+
+
+//-----------------------------------------------------------------------------
+// Interrupt Subroutines
+//-----------------------------------------------------------------------------
+
+// For DMA0 (last slot handed to UART2)
+void __attribute__((interrupt, no_auto_psv)) _DMA0Interrupt(void)
+{
+	U2STAbits.UTXISEL0 = 1;			// UART may still be shifting the last few slots.
+	IFS1bits.U2TXIF = 0;			// Interrupt when the last one is out.
+	IEC1bits.U2TXIE = 1;
+	IFS0bits.DMA0IF = 0;			// Clear the flag
+}
+
+
+// For UART2 Tx (frame completely on the wire)
+void __attribute__((interrupt, no_auto_psv)) _U2TXInterrupt(void)
+{
+	IEC1bits.U2TXIE = 0;
+	U2STAbits.UTXISEL0 = 0;			// Back to DMA requests
+	dmxTxBusy = 0;
+	IFS1bits.U2TXIF = 0;			// Clear the flag
+	if(dmxDone)
+		dmxDone();
+}
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Start code and slots, called after MAB
+static void dmxtx_data(void)
+{
+	DMA0STA = __builtin_dmaoffset(dmxBuf[dmxFront]);
+	DMA0CNT = dmxBufSlots[dmxFront];	// Number of transfers - 1 (start code + slots)
+	DMA0CONbits.CHEN = 1;			// Enable the channel
+	DMA0REQbits.FORCE = 1;			// First byte by hand, UART2 Tx requests do the rest
+}
+
+
+// Configure DMA0 for one-shot, byte wide, RAM to UART2 transfers.
+// 'done' is called from the interrupt when a frame is completely out.
+void dmxtx_init(void (*done)(void))
+{
+	dmxDone = done;
+	dmxbrk_init();
+	DMA0CON = 0x6001;				// Byte size, RAM to peripheral, post-increment, one-shot. Channel off.
+	DMA0REQ = U2TX_IRQ;				// Triggered by UART2 Tx
+	DMA0PAD = (unsigned int)(unsigned long)&U2TXREG;	// SFR address, a long holds a pointer on both builds
+	IFS0bits.DMA0IF = 0;			// Clear the flag
+	IEC0bits.DMA0IE = 1;			// Enable DMA0 interrupt
+}
+
+
+// Staging buffer. It always holds the latest frame including uncommitted
+// writes, and it moves with every commit, so get it again after one.
+unsigned char *dmxtx_getBuf(void)
+{
+	return dmxBuf[dmxStage];
+}
+
+
+// Slots 'lo' to 'hi' (0 = start code) of the staging buffer were written
+void dmxtx_mark(unsigned int lo, unsigned int hi)
+{
+	int i;
+
+	for(i=0;i<3;i++)
+	{
+		if(i == dmxStage)
+			continue;
+		if(lo < staleLo[i])
+			staleLo[i] = lo;
+		if(hi > staleHi[i])
+			staleHi[i] = hi;
+	}
+}
+
+
+// Hand the staging buffer (start code and slots 1..'slots') over. It goes
+// on the wire with the next dmxtx_start(), unless another commit comes first.
+void dmxtx_commit(unsigned int slots)
+{
+	int ipl, last = dmxStage;
+
+	dmxBufSlots[last] = slots;
+
+	SET_AND_SAVE_CPU_IPL(ipl, 7);	// dmxtx_start() runs from interrupts
+	dmxStage = dmxReady;
+	dmxReady = last;
+	dmxNew = 1;
+	RESTORE_CPU_IPL(ipl);
+
+	if(staleLo[dmxStage] <= staleHi[dmxStage])	// Catch up with the frame just committed
+		memcpy(&dmxBuf[dmxStage][staleLo[dmxStage]], &dmxBuf[last][staleLo[dmxStage]],
+				staleHi[dmxStage] - staleLo[dmxStage] + 1);
+	staleLo[dmxStage] = 513;
+	staleHi[dmxStage] = 0;
+}
+
+
+// Is a committed frame still waiting for its turn?
+int dmxtx_ready(void)
+{
+	return dmxNew;
+}
+
+
+// Start a frame after 'markUs' of mark. The bus must be idle (!dmxtx_busy()).
+// Returns 0 if nothing was ever committed.
+int dmxtx_start(unsigned int markUs)
+{
+	int temp;
+
+	if(dmxNew)						// New frame committed? Swap ready and front.
+	{
+		temp = dmxFront;
+		dmxFront = dmxReady;
+		dmxReady = temp;
+		dmxNew = 0;
+	}
+	if(dmxBufSlots[dmxFront] == 0)	// Nothing committed yet
+		return 0;
+
+	dmxTxBusy = 1;
+	dmxbrk_startAfter(markUs, dmxtx_data);	// Break and MAB, then the DMA takes over
+	return 1;
+}
+
+
+// Is there a frame in flight?
+int dmxtx_busy(void)
+{
+	return dmxTxBusy;
+}
@@ -0,0 +1,26 @@
+/*! \file dmxtx.h \brief DMA driven DMX frame transmitter. */
+//*****************************************************************************
+//
+// File Name	: 'dmxtx.h'
+// Title		: DMX frame transmitter
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __DMXTX_H__
+ #define __DMXTX_H__
+
+
+//Functions
+void dmxtx_init(void (*done)(void));
+unsigned char *dmxtx_getBuf(void);
+void dmxtx_mark(unsigned int lo, unsigned int hi);
+void dmxtx_commit(unsigned int slots);
+int dmxtx_ready(void);
+int dmxtx_start(unsigned int markUs);
+int dmxtx_busy(void);
+
+#endif
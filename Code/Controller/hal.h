@@ -0,0 +1,42 @@
+/*! \file hal.h \brief What the chip and the host build do differently. */
+//*****************************************************************************
+//
+// File Name	: 'hal.h'
+// Title		: Hardware abstraction
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//
+// The peripherals are driven through their registers by 'uart1.c',
+// 'uart2.c', 'timebase.c', 'dmxbrk.c', 'pwm.c' and the others. On the chip
+// these are the Microchip SFRs. The host build (Code/Host) compiles the same
+// files against a register image with a peripheral model behind it, and
+// 'delay.s' has a C twin there. What can't be a register is here:
+// - hal_spin() goes into every busy wait. The chip just spins; on the host
+//   the model has to move on, or the wait never ends.
+// - the RS485 direction pin, wired the same on both boards.
+// Same file in Controller and Device.
+//*****************************************************************************
+
+#ifndef __HAL_H__
+ #define __HAL_H__
+
+#include <p33FJ128MC802.h>
+
+
+#ifdef SIM_HOST
+ #define hal_spin() sim_spin()		// Model runs for 1us
+#else
+ #define hal_spin()					// Peripheral gets there on its own
+#endif
+
+#define dmxWrOn LATBbits.LATB8		// RS485 Read/Write Enable Pin RB8 (pin17)
+
+
+//Functions ('delay.s')
+extern void wait_us(unsigned int n);
+extern void wait_ms(unsigned int n);
+
+#endif
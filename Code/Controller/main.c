@@ -53,19 +53,23 @@ SP3232E RS-232 Interface
 #include <stdio.h>
 #include "uart1.h"
 #include "uart2.h"
+#include "dmxtx.h"
+#include "dmxbrk.h"
+#include "dmxsched.h"
+#include "discover.h"
+#include "timebase.h"
+#include "brkdet.h"
+#include "rdmctl.h"
+#include "hal.h"
 #include "main.h"
 
 
-#define dmxWrOn LATBbits.LATB8		// RS485 Read/Write Enable Pin RB8 (pin17)
-
-
 #define pollCode 0xF0				// Start code for POLL
+#define pollWinCode 0xF1			// Start code for POLL of an address window
 #define dataCode 0x00				// Start code for normal data
-
-
-//-------- Delay functions --------//
-extern void wait_us(unsigned int n); 
-extern void wait_ms(unsigned int n);
+#define RDM_WAIT_US 2800				// E1.20: an answer may take this long to start
+#define RDM_GAP_US 2100				// and have gaps this long between its slots
+#define POLL_REPLY_US 1000			// Longest answer after its Break (MAB and 9 bytes take ~420us)
 
 
 //-----------------------------------------------------------------------------
@@ -75,13 +79,54 @@ extern void wait_ms(unsigned int n);
 // For UART1 Tx
 void __attribute__((interrupt, no_auto_psv)) _U1TXInterrupt(void)
 {
-	if(rd_index != wr_index)			// Is there any data available to send?
+	int data;
+
+	IFS0bits.U1TXIF = 0;				// Clear the flag first, a kick may come meanwhile
+	while(!U1STAbits.UTXBF)				// Fill the Tx FIFO
 	{
-		U1TXREG = txBuf[rd_index++];	// Put data into Tx buffer and increse index by 1
-		FULL = 0;						// if the buffer was FULL, now at least one space available to store new byte in the Txbuff.
+		data = ring_get(&txRing);		// Is there any data available to send?
+		if(data < 0)
+			break;
+		U1TXREG = data;
 	}
+}
 
-	IFS0bits.U1TXIF = 0;				// Clear the flag
+
+// For UART1 Rx. Builds complete lines and frames in 'rxBuf'.
+void __attribute__((interrupt, no_auto_psv)) _U1RXInterrupt(void)
+{
+	unsigned char data;
+	int result;
+
+	while(U1STAbits.URXDA)				// Empty the FIFO
+	{
+		data = U1RXREG;
+		result = binlink_rx(data);		// Part of a binary frame?
+		if(rxMsg == MSG_FRAME && (result == BIN_NONE || result == BIN_HEAD))
+			rxAbort();					// Frame before this byte stalled
+
+		if(result == BIN_NONE)
+			rxText(data);				// Typed character
+		else if(result == BIN_HEAD)
+		{
+			if(rxMsg)
+				rxAbort();				// Typing cut off by a frame
+			rxBegin(MSG_FRAME);
+		}
+		else if(result == BIN_BUSY)
+			rxPutByte(data);
+		else if(result == BIN_DROP)
+			rxAbort();
+		else
+			rxEnd(result == BIN_FRAME ? MSG_FRAME : MSG_BAD);
+	}
+
+	if(U1STAbits.OERR)					// FIFO overrun, bytes are gone
+	{
+		U1STAbits.OERR = 0;
+		rxDropped++;
+	}
+	IFS0bits.U1RXIF = 0;				// Clear the flag
 }
 
 
@@ -115,116 +160,351 @@ void __attribute__((interrupt, no_auto_psv)) _T1Interrupt (void)
 void brkFunc(unsigned char startCode)
 {
 	/*-- Initiating BREAK and MAB --*/
-	while(!U2STAbits.TRMT || !U2STAbits.RIDLE);			// Wait till Tx buffer is empty and till Rx is idle
+	while(!U2STAbits.TRMT || !U2STAbits.RIDLE)			// Wait till Tx buffer is empty and till Rx is idle
+		hal_spin();
 	
 	dmxWrOn = 1;					// DMX Write Enable
-	U2BRG = BAUD_96153;				// Slow the Baud Rate 
-	uart2_putc(0);					// Sending Break and MAB
-	while(!U2STAbits.TRMT);			// Wait till Brk & MAB transmitted
+	dmxbrk_start(0);				// Break and MAB from Timer3
+	while(dmxbrk_busy()) hal_spin();	// Start code has to follow the MAB
 	/*---- Break and MAB end ----*/
-			
 
-	U2BRG = BAUD_250K;				// Return to default speed.
 	uart2_putc(startCode);			// Send Start Code 
 }
 
 
+//******************************************//
+// Read what a device sends after its Break //
+//******************************************//
+unsigned int pollReply(unsigned char reply[])
+{
+	unsigned int n = 0;
+	unsigned long start = tb_now();
+	unsigned char data;
+
+	while(tb_now() - start < POLL_REPLY_US*TB_PER_US)	// A babbling line can't hold us
+	{
+		if(U2STAbits.URXDA)
+		{
+			if(U2STAbits.FERR)		// The Break itself, or a broken byte
+				uart2_getc();
+			else
+			{
+				data = uart2_getc();
+				if(n < DISC_REPLY_LEN)
+					reply[n++] = data;
+			}
+		}
+		else if(brkdet_idle())		// Line high for two slots: answer is over
+			break;
+		else
+			hal_spin();
+	}
+	return n;
+}
+
+
 //****************************//
 // POLL data sending function //
 //****************************//
-int poll(int min, int max)
+unsigned int poll(unsigned int min, unsigned int max)
 {
-	int i,j;						// 'for loop' variables
-	char pollData[512];				// Poll Buffer
+	unsigned int i,j;				// 'for loop' variables
+	unsigned char mask;
+	unsigned char reply[DISC_REPLY_LEN];
 
 
-	for(i=1;i<513;i++)				// Prepare poll data. Set '1' from min to max, '0' for the rest
+	if(pollLegacy)
 	{
-		if(i>=min && i<=max) 
-			pollData[i-1] = 1;		// pollData start from 0 to 511
-		else 
-			pollData[i-1] = 0;
+		brkFunc(pollCode);			// Send Break and MAB, with Start Code 0xF0
+
+		for(i=1;i<513;i++)			// '1' from min to max, '0' for the rest and for found devices
+		{
+			uart2_putc(i>=min && i<=max && !disc_found(i));
+		}
 	}
-	
-	if(pollDevAddrIndex>0)			// Did we already find any device address on the bus?
+	else
 	{
-		for(i=1,j=0;i<513;i++) 		// If so, check and set those address's poll data as 0
+		brkFunc(pollWinCode);		// Start Code 0xF1, then min and max (low byte first)
+		uart2_putc(min & 0xFF);
+		uart2_putc(min >> 8);
+		uart2_putc(max & 0xFF);
+		uart2_putc(max >> 8);
+
+		for(i=min;i<=max;i+=8)		// A bit per address in the window, '1' for found devices
 		{
-			if(i == pollDevAddr[j])	
-			{
-				pollData[i-1] = 0;
-				j++;
-				if(j>= pollDevAddrIndex) break; // If we already clear all 'Found' devices address, no need to check further
-			}
-		}	
+			mask = 0;
+			for(j=0;j<8 && i+j<=max;j++)
+				if(disc_found(i+j))
+					mask |= 1 << j;
+			uart2_putc(mask);
+		}
 	}
 
-	brkFunc(pollCode);				// Send Break and MAB, with Start Code 0xF0
-	
-	for(i=0;i<512;i++)
+	while(!U2STAbits.TRMT) hal_spin();	// Wait till data transmit ends
+
+	while(U2STAbits.URXDA)			// Nothing old in front of the answer
+		uart2_getc();
+	U2STAbits.OERR = 0;				// Receiver stops after an overrun
+	dmxWrOn = 0;					// Enable read mode
+	brkdet_arm();					// Edges on U2RX are time stamped from here
+
+	while((i = brkdet_check()) == BRKDET_WAIT)
+		hal_spin();
+	if(i == BRKDET_BREAK)
 	{
-		uart2_putc(pollData[i]);	// Send all 512 data
+		redTimeout = 250;			// Set RED LED, indicate valid break receive
+		LATBbits.LATB5 = 1;
+		i = disc_decode(reply, pollReply(reply));	// Address of a lone device, or DISC_NOADDR
+		brkdet_stop();
+		return i;
 	}
+	brkdet_stop();
+	return DISC_QUIET;				// No Break in time, or only glitches
+}
+
+
+//**************************************************//
+// RDM request out, its answer (without Break) back //
+//**************************************************//
+unsigned int rdmXfer(const unsigned char req[], unsigned int len, unsigned char resp[])
+{
+	unsigned int i, n = 0;
+	unsigned long last;
 
-	while(!U2STAbits.TRMT);			// Wait till data transmit ends
+	brkFunc(req[0]);				// Break, MAB and start code 0xCC
+	for(i=1;i<len;i++)
+		uart2_putc(req[i]);
+	while(!U2STAbits.TRMT) hal_spin();	// Wait till the request is out
 
+	while(U2STAbits.URXDA)			// Nothing old in front of the answer
+		uart2_getc();
+	U2STAbits.OERR = 0;
 	dmxWrOn = 0;					// Enable read mode
 
-	for(i=0;i<60;i++)				// To detect a data zero with a frame error requires 44uS, we will check for data till 60uS
+	last = tb_now();
+	while(n < RDM_PKT_MAX && !rdm_complete(resp, n))
 	{
-		if(U2STAbits.URXDA)					// Is there any data?
+		if(U2STAbits.URXDA)
 		{
-			if(U2STAbits.FERR)				// Is it with frame error?
-			{	
-				if(uart2_getc() == 0)		// Is it Break?
-				{
-					redTimeout = 250;		// Set RED LED, indicate valid break receive
-					LATBbits.LATB5 = 1;
-					return 1;				// Got a response, return 1
-				}
-			}
+			if(U2STAbits.FERR)		// Break in front of the answer
+				uart2_getc();
 			else
-			{
-				uart2_getc();				// To avoid overrun keep reading the data.
-			}
+				resp[n++] = uart2_getc();
+			last = tb_now();
 		}
-		wait_us(1);
+		else if(tb_now() - last > (n ? RDM_GAP_US : RDM_WAIT_US)*(unsigned long)TB_PER_US)
+			break;					// Nobody answers, or the answer stopped
+		else
+			hal_spin();
 	}
-	return 0;								// No response found, return 0
+	return n;
+}
+
+
+//*******************************************//
+// Bus time of a search as seconds, 3 digits //
+//*******************************************//
+void sendBusTime(unsigned long us)
+{
+	char buffer[6];
+	unsigned long ms = us/1000;		// Legacy POLL of 512 devices takes more than 32767 ms
+
+	itoa(buffer,ms/1000,10);
+	send_string(buffer);
+	itoa(buffer,ms%1000+1000,10);	// Three digits after the point
+	buffer[0] = '.';
+	send_string(buffer);
+	send_string(" s");
 }
 
 
-//**********************************************************//
-// Find all devices addresses in the bus //
-//**********************************************************//
-void findDevice()
+//******************************************//
+// Print the devices found and what it cost //
+//******************************************//
+void pollReport()
 {
-	int min=1,max,temp;
-	pollDevAddrIndex = 0; 		// Initialize number of devices variable
+	char buffer[6];					// Variable for itoa
+	unsigned int addr;
 
-	while(poll(1,512))			// Is there any device at all?
+	if(disc_count())				// Did we find any device?
 	{
-		max = 512;
-		while(1)
+		for(addr=disc_next(0);addr;addr=disc_next(addr))	// Print all the address in UART1
 		{
-			if(poll(min,max))
-			{
-				if(min == max)	// We found one device address
-				{
-					pollDevAddr[pollDevAddrIndex++] = min;
-					break;		// return back to '1 to 512' range and do everything again.
-				}
-				max = (min+max-1)>>1;	// Devide the range into half
-			}
-			else						// Didn't get response from left tree, so set min and max value for right tree
-			{
-				temp = min;			
-				min = max+1;
-				max = (max*2)+1-temp;
-			}
+			itoa(buffer,addr,10);
+			send_string("\r\n");
+			send_string(buffer);
+			send_string(" ");
 		}
 	}
-	// Found all the available device (if there is any) in the bus
+	else send_string(noDev);		// No device found on the bus
+	itoa(buffer,disc_probes(),10);	// What the search cost
+	send_string("\r\n");
+	send_string(buffer);
+	send_string(" probes, ");
+	sendBusTime(disc_busUs());
+	send_string(ready);
+}
+
+
+//*******************************//
+// UID as mmmm:dddddddd (in hex) //
+//*******************************//
+void sendUid(const unsigned char uid[])
+{
+	const char hex[] = "0123456789ABCDEF";
+	char buffer[2*RDM_UID_LEN+2];
+	int i, n = 0;
+
+	for(i=0;i<RDM_UID_LEN;i++)
+	{
+		if(i == 2)
+			buffer[n++] = ':';
+		buffer[n++] = hex[uid[i] >> 4];
+		buffer[n++] = hex[uid[i] & 0xF];
+	}
+	buffer[n] = 0;
+	send_string(buffer);
+}
+
+
+//**********************************************//
+// Print the RDM Devices found and what it cost //
+//**********************************************//
+void rdmReport()
+{
+	char buffer[6];
+	unsigned int i;
+
+	if(!rdmctl_count())
+		send_string(noDev);
+	for(i=0;i<rdmctl_count() && i<RDMCTL_DEVS;i++)	// Numbered for 'rdminfo', 'rdmaddr' and 'rdmid'
+	{
+		itoa(buffer,i+1,10);
+		send_string("\r\n");
+		send_string(buffer);
+		send_string(" ");
+		sendUid(rdmctl_uid(i));
+	}
+	if(rdmctl_count() > RDMCTL_DEVS)
+	{
+		itoa(buffer,rdmctl_count()-RDMCTL_DEVS,10);
+		send_string("\r\n");
+		send_string(buffer);
+		send_string(" more, not kept");
+	}
+	itoa(buffer,rdmctl_xfers(),10);	// What the search cost
+	send_string("\r\n");
+	send_string(buffer);
+	send_string(" requests, ");
+	sendBusTime(rdmctl_busUs());
+	send_string(ready);
+}
+
+
+//**********************************************//
+// Request of 'rdminfo', 'rdmaddr' or 'rdmid'   //
+//----------------------------------------------//
+// Runs between two DMX frames like a POLL step //
+//**********************************************//
+void rdmRun()
+{
+	const unsigned char *uid = rdmctl_uid(rdmArg[0]-1);
+	unsigned char pd[RDM_PD_MAX];
+	unsigned int pdl = 0;
+	char buffer[6];
+	int result;
+
+	if(dmxOn)
+	{
+		dmxsched_hold();			// Next frame waits for the request
+		while(dmxtx_busy())
+			hal_spin();
+	}
+	if(rdmFlag == RDM_INFO)
+		result = rdmctl_get(uid, RDM_PID_DEVINFO, pd, &pdl);
+	else if(rdmFlag == RDM_ADDR)
+	{
+		pd[0] = rdmArg[1] >> 8;
+		pd[1] = rdmArg[1] & 0xFF;
+		result = rdmctl_set(uid, RDM_PID_ADDR, pd, 2);
+	}
+	else
+	{
+		pd[0] = rdmArg[1];
+		result = rdmctl_set(uid, RDM_PID_IDENTIFY, pd, 1);
+	}
+	dmxWrOn = 1;					// DMX Write On
+	dmxsched_release();
+	rdmFlag = 0;
+
+	send_string("\r\n");
+	sendUid(uid);
+	if(result == RDMCTL_NOREPLY)
+		send_string(" no answer");
+	else if(result == RDMCTL_BAD)
+		send_string(" bad answer");
+	else if(result == RDMCTL_NACK)
+	{
+		send_string(" NACK ");
+		itoa(buffer,rdmctl_nack(),10);
+		send_string(buffer);
+	}
+	else if(pdl >= RDM_DEVINFO_LEN)
+	{
+		send_string(" model ");
+		itoa(buffer,(pd[2] << 8) | pd[3],10);
+		send_string(buffer);
+		send_string(", footprint ");
+		itoa(buffer,(pd[10] << 8) | pd[11],10);
+		send_string(buffer);
+		send_string(", address ");
+		itoa(buffer,(pd[14] << 8) | pd[15],10);
+		send_string(buffer);
+	}
+	else
+		send_string(" done");
+	send_string(ready);
+}
+
+
+//**************************************************//
+// One POLL probe in the gap between two DMX frames //
+//**************************************************//
+void pollStep()
+{
+	int done, kind = pollOn;
+	unsigned long worstUs = (kind == SEARCH_RDM) ? rdmctl_worstUs() : disc_worstUs();
+
+	if(dmxOn)
+	{
+		dmxsched_hold();			// Next frame waits for the probe
+		if(dmxtx_busy())
+			return;					// Frame on the wire ends first
+
+		if(pollMinRate && dmxsched_sinceBrkUs() + worstUs > 1000000UL/pollMinRate
+				&& tb_now() - pollLast < 1000000UL*TB_PER_US)
+		{
+			dmxsched_release();		// Too slow for this gap. Still one probe a second.
+			return;
+		}
+	}
+
+	pollLast = tb_now();
+	if(kind == SEARCH_RDM)
+		done = (rdmctl_step() == RDMCTL_DONE);
+	else
+		done = (disc_step() == DISC_DONE);
+	dmxWrOn = 1;					// DMX Write On
+	dmxsched_release();
+
+	if(done)
+	{
+		pollOn = 0;
+		if(kind == SEARCH_RDM)
+			rdmReport();
+		else
+			pollReport();			// Results come whenever the search is over
+	}
 }
 
 
@@ -234,67 +514,74 @@ void findDevice()
 
 int main()
 {
-   	int dmxIndex;				// Index Variable for RS485 buffer
-	char buffer[6];				// Variable for itoa
+	unsigned int msgLen;
+	int msgKind;
 
    	init_hw();					// Initialize hardware
+	ring_init(&txRing, txBuf, TX_SIZE, txKick);
+	ring_init(&rxRing, rxBuf, RX_SIZE, 0);
    	uart1_init(BAUD_19200);		// Configure uart1
-	uart2_init(BAUD_96153);		// Configure uart2
+	IFS0bits.U1RXIF = 0;		// Commands are received by interrupt
+	IEC0bits.U1RXIE = 1;
+	uart2_init(BAUD_250K);		// Configure uart2
 	timer1_init(625);			// (625*64)/40M = 1ms
+	dmxsched_init();			// Frame timing and DMA for the DMX frames
+	binlink_init(send_byte);	// Binary frames next to the text commands
+	disc_init(poll);			// Device search with POLL frames
+	brkdet_init();				// Time stamps the answers to POLL on U2RX
+	rdmctl_init(rdmXfer, rdmUid);	// RDM requests through UART2 as well
     
 	dmxWrOn = 1; 				// DMX Write On
 	clrDmxData();				// Initialize DMX buffer with zero
+	commitDmx();				// First frame
 	
    	LATBbits.LATB4 = 1;			// Blink green LED for 500ms, Step 1
    	wait_ms(500);
    	LATBbits.LATB4 = 0;
 
 	send_string(welcome);		// Welcome String
+	dmxsched_start();			// Frames run from interrupts from now on
 
    	while(1)
    	{
-		if(dmxOn)							// Is DMX on?
+		if(pollFlag)
 		{
-			brkFunc(dataCode);				// Send Break,MAB with start code 0x00
-			dmxIndex = 1;					// Initialize DMX buffer index
-			
-			while(dmxIndex<=maxDmxAddr)		// Send data till max addr
-			{
-				uart2_putc(dmxData[dmxIndex++]);
-				
-				if(U1STAbits.URXDA)			// Cheack if there is any data in UART1.
-				{
-					processCmd();	
-				}
-			}
-			
-			if(pollFlag == 1)				
-			{
-				pollFlag = 0;
-				findDevice();					// Find available device addresses in the bus
-
-				if(pollDevAddrIndex>0)			// Did we find any device?
-				{
-					pollDevAddrIndex--;			// Decrement one
-					while(pollDevAddrIndex>=0)	// Print all the address in UART1
-					{
-						itoa(buffer,pollDevAddr[pollDevAddrIndex--],10);
-						send_string("\r\n");
-						send_string(buffer);
-						send_string(" ");
-					}
-				}
-				else send_string(noDev);		// No device found on the bus
-				send_string(ready);
-			}
+			if(pollFlag == SEARCH_RDM)
+				rdmctl_start();
+			else
+				disc_start();				// (Re)start the search, it runs between the DMX frames
+			pollOn = pollFlag;
+			pollFlag = 0;
+		}
+		if(pollOn)
+			pollStep();
+		if(rdmFlag)
+			rdmRun();
+
+		msgKind = getMsg(&msgLen);			// Complete line or frame from UART1?
+		if(msgKind)
+		{
+			if(msgKind == MSG_TEXT)
+				processCmd((char *)msgBuf);
+			else if(msgKind == MSG_LONG)
+				send_string(errMsg);		// Line too long, nothing of it ran
+			else
+				processBin(msgKind, msgBuf);
+
+			if(autoCommit && dmxDirty)		// Everything a cmd changed goes out in the same frame
+				commitDmx();
 		}
-		else if(U1STAbits.URXDA)			// DMX is off. So check if there is any data in UART1
+
+		if(newBrg)							// Baud change, after the reply is out
 		{
-			processCmd();
+			while(ring_count(&txRing) || !U1STAbits.TRMT)
+				hal_spin();
+			U1MODEbits.BRGH = 1;
+			U1BRG = newBrg;
+			newBrg = 0;
 		}
+		hal_spin();
    	}
 
    	return 0;
 }
-
-
@@ -46,42 +46,73 @@ See 'main.c'
 #include <ctype.h>
 #include "uart1.h"
 #include "uart2.h"
+#include "dmxtx.h"
+#include "dmxbrk.h"
+#include "dmxsched.h"
+#include "binlink.h"
+#include "ring.h"
 
 
 
 #define BAUD_19200 129                       // brg for low-speed, 40 MHz clock // UART1-->round((40000000/16/19200)-1)
 #define BAUD_250K 9							 // UART2-->(40M/16/250K)-1 
-#define BAUD_96153 25						 // UART2-->(40M/16/96513)-1 (For Break and MAB) 
-											 // This baudrate will give 20us MAB and 93us Break 
+
+#define TX_SIZE 256					// UART1 rings, power of 2
+#define RX_SIZE 1024
+#define LINE_MAX (BIN_MAX_LEN+3)	// Characters in a typed line (fits 'msgBuf')
+#define MSG_TEXT 1					// Message kinds in the Rx ring
+#define MSG_FRAME 2
+#define MSG_BAD 3
+#define MSG_LONG 4					// Typed line longer than LINE_MAX, nothing of it kept
+#define SEARCH_POLL 1				// Kinds of search, 'pollFlag' and 'pollOn'
+#define SEARCH_RDM 2
+#define RDM_INFO 1					// Kinds of 'rdmFlag'
+#define RDM_ADDR 2
+#define RDM_IDENTIFY 3
 
 
 // Constants Array
 const char errMsg[] = "\r\nError. Type 'help'.\r\n";
 const char ready[] = "\r\nReady.\r\n";
 const char noDev[] = "\r\nNo Device Found.\r\n";
+const unsigned char rdmUid[RDM_UID_LEN] = {RDM_MANUF >> 8, RDM_MANUF & 0xFF, 0x80, 0, 0, 0};	// Our RDM UID, Devices count from 1
 const char welcome[] = "\r\nWelcome.\r\nFor cmd type 'help'.\r\n";
-const char help[] = "\r\nCmds are case insensetive.\r\nAdr:1 to 512; data:0 to 255\r\n---------------------------\r\nset Adr data\r\nget Adr\r\nmax Adr\r\non\r\noff\r\npoll\r\nclear\r\n";
+const char help[] = "\r\nCmds are case insensetive.\r\nAdr:1 to 512; data:0 to 255\r\nSeveral cmds in a line: cmd;cmd;...\r\n---------------------------\r\nset Adr data [data..]\r\nfill Adr Adr data\r\nsetrange Adr Adr data [data..]\r\ncopy from to count\r\nramp Adr Adr data data\r\nget Adr\r\nmax Adr (0=auto)\r\nfloor Adr\r\non\r\noff\r\npoll\r\nrdm (RDM search)\r\nrdminfo n\r\nrdmaddr n Adr\r\nrdmid n 0|1\r\nminrate Hz (DMX kept while polling, 0=off)\r\nlegacy 0|1 (0xF0 poll)\r\nclear\r\nbrk us (92-1600)\r\nmab us (12-1600)\r\nrate Hz (0=max,3-1000)\r\nmbb us (0-1000)\r\nstats\r\ncommit\r\nauto 0|1\r\nbaud kbit/s (19,38,57,115,250,500,1000)\r\n";
 
 
 
 // Global Variables
-unsigned char dmxData[513];			// RS485 Buffer
-int pollDevAddr[10];				// Available Device Address Storage; Right now assuming there can be max 10 device in the bus. 
-int pollDevAddrIndex = 0;
-unsigned int maxDmxAddr = 512;		// Max Data slot for RS485
+unsigned int maxDmxAddr = 512;		// Max Data slot for RS485, 0 = up to the highest written one
+unsigned int highDmxAddr = 0;		// Highest slot written since 'clear'
+unsigned int minDmxAddr = 24;		// Fewest slots in a frame when 'max' is 0
 unsigned char dmxOn = 1;			// RS485 On/Off
+unsigned char autoCommit = 1;		// Commit the DMX buffer after every cmd
+int dmxDirty = 0;					// DMX buffer has changes not committed yet
 
+unsigned char pollLegacy = 0;		// POLL with 512 slot 0xF0 frames for old Devices
 int pollFlag=0;						// POLL commands flag. Execute outside of the processCMD function.
+int pollOn = 0;						// Device search running between the DMX frames
+int rdmFlag = 0;					// RDM request for a found Device, done in the main loop
+unsigned int rdmArg[2];				// Its Device number (as listed by 'rdm') and value
+unsigned int pollMinRate = 20;		// DMX refresh (Hz) the search has to leave, 0 = don't care
+unsigned long pollLast;				// Time stamp of the last probe
+unsigned int newBrg=0;				// UART1 baud change, done once 'Ready' is out
 
-char type[5],inStr[21];				// User string (from UART1) parsing variables.
-unsigned int pos[5];				
-unsigned int field_count;
+unsigned int cmdArg[LINE_MAX/2+1];	// Numbers of all the cmds of a line
 
 // UART1 Tx interrupt variables
-unsigned char txBuf[256];			// Ring Buffer
-unsigned char wr_index=0;			// Tx Buffer write & read index
-unsigned char rd_index=0;			// unsigned char so after 255 they automatically return to zero.
-int FULL=0;							// Buffer full flag
+unsigned char txBuf[TX_SIZE];
+RING txRing;						// Main loop -> Tx interrupt
+
+// UART1 Rx interrupt variables. Each message in the ring is
+// kind, length (2 bytes), then the line or the frame without sync and checksum.
+unsigned char rxBuf[RX_SIZE];
+RING rxRing;						// Rx interrupt -> main loop, a message is one pending block
+unsigned char rxMsg=0;				// Kind of the message in progress, 0 if none
+int rxOverflow=0;					// It didn't fit, drop it at its end
+int rxLong=0;						// Typed line ran past LINE_MAX, drop it up to the CR
+unsigned int rxDropped=0;			// Lines and frames lost
+unsigned char msgBuf[BIN_MAX_LEN+4];	// Message taken out of the ring
 
 
 // Timer1 Interrupt Variables
@@ -129,240 +160,811 @@ void timer1_init(unsigned int period)
 }
 
 
-//********************************************//
-// Put data in 'txBuf' for UART1 Tx interrupt //
-//********************************************//
+//***************************************//
+// Queue a string for UART1 Tx interrupt //
+//***************************************//
 void send_string(const char str[])
 {
-	int i=0;
-	
-	while (str[i] != 0 && !FULL)			// Write to buffer if it isn't FULL
+	ring_write(&txRing,(const unsigned char *)str,strlen(str),RING_BLOCK);	// Waits for room, nothing is cut off
+}
+
+
+//*************************************//
+// Queue a byte for UART1 Tx interrupt //
+//*************************************//
+void send_byte(unsigned char data)
+{
+	ring_put(&txRing,data,RING_BLOCK);
+}
+
+
+// Start the Tx interrupt chain, the interrupt takes it from there
+void txKick()
+{
+	IFS0bits.U1TXIF = 1;
+}
+
+
+//*****************************************//
+// UART1 baud rate for a kbit/s, 0 if none //
+//*****************************************//
+unsigned int linkBrg(unsigned int kbaud)
+{
+	const unsigned int brg[][2] = {			// High speed BRG: (40M/4/baud)-1
+		{19, 520}, {38, 259}, {57, 173}, {115, 86}, {250, 39}, {500, 19}, {1000, 9}};
+	int i;
+
+	for(i=0;i<sizeof(brg)/sizeof(brg[0]);i++)
 	{
-		txBuf[wr_index++] = str[i++];
-		if((wr_index+1)%256 == rd_index)	// Is next byte going to overwrite the buffer?
-			FULL = 1;						// Then SET FULL
-		else 
-			FULL = 0;
+		if(brg[i][0] == kbaud)
+			return brg[i][1];
 	}
-	if(U1STAbits.UTXBF == 0) 				// Is TX FIFO is completely empty?
-		U1TXREG = txBuf[rd_index++];		// Then at least write one byte to FIFO to start interrupt
+	return 0;
 }
 
 
-//*************************//
-// Get character from UART //
-//*************************//
-int getInputChar()
+//******************************************//
+// Rx ring: messages built in the interrupt //
+//******************************************//
+void rxPutByte(unsigned char data)
 {
-   unsigned char temp;				
-   static unsigned int count = 0;	// Limit user input within 20 character
-   
-   temp = uart1_getc();				// Get Character
-   if((temp == 8) && (count>0))		// Is it 'backspace'?
+	if(!ring_pend(&rxRing,data))	// Would run into the main loop
+		rxOverflow = 1;
+}
+
+
+void rxBegin(unsigned char kind)
+{
+	rxMsg = kind;
+	rxOverflow = 0;
+	rxLong = 0;
+	ring_discard(&rxRing);
+	rxPutByte(kind);				// Header, length filled in at the end
+	rxPutByte(0);
+	rxPutByte(0);
+}
+
+
+void rxEnd(unsigned char kind)
+{
+	unsigned int len = ring_pending(&rxRing) - 3;
+
+	if(rxOverflow)
+	{
+		ring_discard(&rxRing);
+		rxDropped++;
+	}
+	else
+	{
+		ring_poke(&rxRing,0,kind);
+		ring_poke(&rxRing,1,len & 0xFF);
+		ring_poke(&rxRing,2,len >> 8);
+		ring_publish(&rxRing);		// Main loop can have it now
+	}
+	rxMsg = 0;
+}
+
+
+// Drop the message in progress. Nothing of it was published.
+void rxAbort()
+{
+	ring_discard(&rxRing);
+	rxMsg = 0;
+}
+
+
+//*************************************//
+// Typed character, from the interrupt //
+//*************************************//
+void rxText(unsigned char temp)
+{
+   if(!rxMsg)
+      rxBegin(MSG_TEXT);
+
+   if(temp == 8)					// Is it 'backspace'?
    {
-      count--;
+      if(ring_pending(&rxRing) > 3 && !rxOverflow && !rxLong)
+         ring_unpend(&rxRing);
    }
-   else if(temp == '\r')			// Is it CR?
+   else if(temp == '\r')			// Is it CR? Line is complete.
    {
-      inStr[count] = NULL;			// Complete the buffer
-	  count = 0;
-	  return 1;
+      if(rxLong)					// Too long: only an empty MSG_LONG for the error reply
+      {
+         rxDropped++;
+         rxBegin(MSG_LONG);
+         rxEnd(MSG_LONG);
+      }
+      else
+         rxEnd(MSG_TEXT);
    }
    else if(temp>=32 && temp<=126)	// Is it a 'Printable character'?
    {
-      inStr[count++]=tolower(temp);	// Store with lower case
-      if(count==20)					// Is buffer full?
-	  {
-		 inStr[count] = NULL;
-		 count = 0;
-		 return 1;
-   	  }   
+      if(ring_pending(&rxRing) - 3 == LINE_MAX)	// Is line full? Don't run a piece of it
+      {
+         ring_discard(&rxRing);
+         rxLong = 1;
+      }
+      else if(!rxLong)
+         rxPutByte(tolower(temp));	// Store with lower case
    }
-   return 0;						// Return 0 if it isn't CR
 }
 
 
-//***********************//
-// Parse the user string //
-//***********************//
-unsigned int parseStr()
+//******************************************//
+// Take the next message out of the Rx ring //
+//******************************************//
+int getMsg(unsigned int *len)		// Returns its kind, 0 if there is none
 {
-   unsigned int i;						// 'for' loop variables
-   unsigned int j=0,errorFlag=0;		// invalid cmd flag
-   unsigned char last_type = 'd';
-   
-   field_count = 0;						// Initialize the global variable
+	unsigned int i;
+	int kind;
+
+	if(ring_count(&rxRing) == 0)	// Only complete messages are published
+		return 0;
+
+	kind = ring_get(&rxRing);
+	*len = ring_get(&rxRing);
+	*len |= ring_get(&rxRing) << 8;
+	for(i=0;i<*len;i++)
+		msgBuf[i] = ring_get(&rxRing);
+	msgBuf[i] = 0;					// Lines are strings
+	return kind;
+}
 
-   for(i=0;inStr[i] != NULL && i<=20; i++)	// parse till string is null or till 20 character
-   {
-      if(isalnum(inStr[i]))				// Is it Alpahanumeric?
-      {
-	     if(isalpha(inStr[i]))			// Is it Alphabet?
-		 {
-		    if(last_type == 'd')		// d -> a transition. Record the position
-			{
-			   pos[j] = i;
-			   type[j++] = 'a';
-			   last_type = 'a';
-			   field_count++;
-			}
-			else if(last_type == 'n')	// n -> a tansition. Error.
-			{
-			   errorFlag = 1;
-			   break;
-			} 
-		 }
-         else if(isdigit(inStr[i]))		// Is it Number?
-		 {
-		    if(last_type == 'd')		// d -> n transition. Record the position.
-			{
-			   pos[j] = i;
-			   type[j++] = 'n';
-			   last_type = 'n';
-			   field_count++;
-			}
-			else if(last_type == 'a')	// a -> n transition. Error.
-			{
-			   errorFlag = 1;
-			   break;
-			}
-		 }
-	  }
-	  else					// If it is not Alphanumeric then it is delimiter. Replace with NULL.
-	  {
-		 inStr[i] = NULL;
-	     last_type = 'd';
-	  }
-   }	
-   return errorFlag;			// Return 1 if there is invalid sequence. Otherwise return zero.
+
+//******************//
+// Clear DMX Buffer //
+//******************//
+void clrDmxData()
+{
+	memset(dmxtx_getBuf(),0,513);	// Start code and all slots
+	dmxtx_mark(0,512);
+	highDmxAddr = 0;				// Nothing patched any more
+	dmxDirty = 1;
 }
 
 
-//*********************//
-// Check Valid Command //
-//*********************//
-int isCmd(char strVerb[], int count) // Check user string with predefined command. Return 1 if it match. Zero otherwise.
+//*****************************************//
+// Staging slots 'first' to 'last' written //
+//*****************************************//
+void slotsWritten(unsigned int first, unsigned int last)
 {
-   return ((strcmp(strVerb, &inStr[pos[0]])==0) && (count == field_count));
+	dmxtx_mark(first,last);
+	if(last > highDmxAddr)
+		highDmxAddr = last;
+	dmxDirty = 1;
 }
 
 
-//********************//
-// atoi for the inStr //
-//********************//
-int getArgNum(int index)
+//*****************************************//
+// Slots in the frame (fixed or automatic) //
+//*****************************************//
+unsigned int frameSlots()
 {
-   return (atoi(&inStr[pos[index]]));	//Change 'addr' and 'value' from ascii to integer
+	if(maxDmxAddr)
+		return maxDmxAddr;
+	return (highDmxAddr > minDmxAddr) ? highDmxAddr : minDmxAddr;	// Short frames, higher refresh rate
 }
 
 
-//******************//
-// Clear DMX Buffer //
-//******************//
-void clrDmxData()
+//*****************************************//
+// Send the DMX buffer with the next frame //
+//*****************************************//
+void commitDmx()
+{
+	dmxtx_commit(frameSlots());		// Swapped in at the next Break, never halfway through a frame
+	dmxDirty = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Command checks and handlers. 'arg' holds the numbers after the verb,
+// already checked against the argument letters in 'cmdTable'. A check
+// returns 0 if the cmd is invalid; handlers only run once every cmd of the
+// line passed, so a line is taken whole or not at all.
+//-----------------------------------------------------------------------------
+
+int chkSet(const unsigned int arg[], int n)
+{
+	return arg[0]+n-2 <= 512;
+}
+
+
+int cmdSet(const unsigned int arg[], int n)	// Values from the address on
 {
+	unsigned char *buf = dmxtx_getBuf();
 	int i;
-	for(i=0;i<513;i++)
+
+	for(i=1;i<n;i++)
+		buf[arg[0]+i-1] = arg[i];
+	slotsWritten(arg[0],arg[0]+n-2);
+	return 1;
+}
+
+
+//*************************************//
+// Send frame rate, jitter & queue use //
+//*************************************//
+void sendStats()
+{
+	char buffer[6];
+	unsigned int rate10 = dmxsched_rate10();
+
+	send_string("\r\nrate ");
+	itoa(buffer,rate10/10,10);
+	send_string(buffer);
+	send_string(".");
+	itoa(buffer,rate10%10,10);
+	send_string(buffer);
+	send_string(" Hz, jitter ");
+	itoa(buffer,dmxsched_jitterUs(),10);
+	send_string(buffer);
+	send_string(" us, slots ");
+	itoa(buffer,frameSlots(),10);
+	send_string(buffer);
+	send_string("\r\ntx queue max ");
+	itoa(buffer,txRing.highWater,10);
+	send_string(buffer);
+	send_string(", rx queue max ");
+	itoa(buffer,rxRing.highWater,10);
+	send_string(buffer);
+	send_string(", rx lost ");
+	itoa(buffer,rxDropped,10);
+	send_string(buffer);
+	send_string(", bus glitches ");	// Lows on U2RX too short for a Break
+	itoa(buffer,brkdet_glitches(),10);
+	send_string(buffer);
+	send_string("\r\nbus stuck ");		// Listen windows given up, line low or restless
+	itoa(buffer,brkdet_stuck(),10);
+	send_string(buffer);
+	dmxsched_clearStats();			// Next jitter covers the time from now on
+}
+
+
+int chkRange(const unsigned int arg[], int n)	// First and last address in order
+{
+	return arg[0] <= arg[1];
+}
+
+
+int cmdFill(const unsigned int arg[], int n)	// One value over a range
+{
+	memset(dmxtx_getBuf()+arg[0],arg[2],arg[1]-arg[0]+1);
+	slotsWritten(arg[0],arg[1]);
+	return 1;
+}
+
+
+int chkSetRange(const unsigned int arg[], int n)	// The list has to fit in the range
+{
+	return arg[0] <= arg[1] && n-2 <= arg[1]-arg[0]+1;
+}
+
+
+int cmdSetRange(const unsigned int arg[], int n)	// Value list repeated over a range
+{
+	unsigned char *p = dmxtx_getBuf()+arg[0];
+	unsigned int len, done, step;
+
+	len = arg[1]-arg[0]+1;
+	for(done=0;done<n-2;done++)	// The list once (fits, see chkSetRange())
+		p[done] = arg[done+2];
+	while(done < len)				// Then doubling copies of what is there
 	{
-		dmxData[i] = 0;
+		step = (done < len-done) ? done : len-done;
+		memcpy(p+done,p,step);
+		done += step;
 	}
+	slotsWritten(arg[0],arg[1]);
+	return 1;
 }
 
-//**************************************//
-// Read user data & process accordingly //
-//**************************************//
-void processCmd()
+
+int chkCopy(const unsigned int arg[], int n)
+{
+	return arg[0]+arg[2]-1 <= 512 && arg[1]+arg[2]-1 <= 512;
+}
+
+
+int cmdCopy(const unsigned int arg[], int n)	// Block from, to, count (may overlap)
+{
+	memmove(dmxtx_getBuf()+arg[1],dmxtx_getBuf()+arg[0],arg[2]);
+	slotsWritten(arg[1],arg[1]+arg[2]-1);
+	return 1;
+}
+
+
+int cmdRamp(const unsigned int arg[], int n)	// Straight line from one value to another
+{
+	unsigned char *p = dmxtx_getBuf()+arg[0];
+	unsigned int i, len;
+	long step, level;
+
+	len = arg[1]-arg[0];
+	step = len ? (((long)arg[3]-(long)arg[2])<<16)/(long)len : 0;	// 16.16 fixed point
+	level = ((long)arg[2]<<16) + 0x8000;	// Rounded
+	for(i=0;i<=len;i++,level+=step)
+		p[i] = level>>16;
+	p[len] = arg[3];				// End exactly on the value
+	slotsWritten(arg[0],arg[1]);
+	return 1;
+}
+
+
+int cmdGet(const unsigned int arg[], int n)
 {
-	int addr, data, invalidCmd=0;	
 	char buffer[6];
 
+	itoa(buffer,dmxtx_getBuf()[arg[0]],10);	// Latest value, committed or not
+	send_string("\r\n");
+	send_string(buffer);
+	return 1;
+}
+
+
+int chkMax(const unsigned int arg[], int n)
+{
+	return arg[0] <= 512;
+}
+
+
+int cmdMax(const unsigned int arg[], int n)
+{
+	maxDmxAddr = arg[0];			// 0: follow the highest written slot
+	dmxDirty = 1;					// Frame length goes with the next commit
+	return 1;
+}
+
+
+int cmdFloor(const unsigned int arg[], int n)
+{
+	minDmxAddr = arg[0];			// For fixtures which want a minimum frame
+	dmxDirty = 1;
+	return 1;
+}
+
+
+int chkBrk(const unsigned int arg[], int n)
+{
+	return arg[0] >= BRK_MIN_US && arg[0] <= BRK_MAX_US;
+}
+
+
+int cmdBrk(const unsigned int arg[], int n)
+{
+	return dmxbrk_set(arg[0], dmxbrk_getMab());	// Break length, keep MAB
+}
+
+
+int chkMab(const unsigned int arg[], int n)
+{
+	return arg[0] >= MAB_MIN_US && arg[0] <= MAB_MAX_US;
+}
+
+
+int cmdMab(const unsigned int arg[], int n)
+{
+	return dmxbrk_set(dmxbrk_getBrk(), arg[0]);	// MAB length, keep Break
+}
+
+
+int cmdClear(const unsigned int arg[], int n)
+{
+	clrDmxData();
+	return 1;
+}
+
+
+int cmdOn(const unsigned int arg[], int n)
+{
+	dmxOn = 1;						// Turn ON the DMX transmission.
+	dmxsched_start();
+	return 1;
+}
+
+
+int cmdOff(const unsigned int arg[], int n)
+{
+	dmxOn = 0;						// Turn OFF the DMX transmission.
+	dmxsched_stop();
+	return 1;
+}
+
+
+int chkRate(const unsigned int arg[], int n)
+{
+	return arg[0] == 0 || (arg[0] >= RATE_MIN && arg[0] <= RATE_MAX);
+}
+
+
+int cmdRate(const unsigned int arg[], int n)
+{
+	return dmxsched_setRate(arg[0]);	// Frames per second, 0 = back to back
+}
+
+
+int chkMbb(const unsigned int arg[], int n)
+{
+	return arg[0] <= MBB_MAX_US;
+}
+
+
+int cmdMbb(const unsigned int arg[], int n)
+{
+	return dmxsched_setMbb(arg[0]);	// Mark before Break
+}
+
+
+int cmdStats(const unsigned int arg[], int n)
+{
+	sendStats();
+	return 1;
+}
+
+
+int cmdCommit(const unsigned int arg[], int n)
+{
+	commitDmx();
+	return 1;
+}
+
+
+int cmdAuto(const unsigned int arg[], int n)
+{
+	autoCommit = arg[0];			// 0: changes wait for 'commit'
+	if(autoCommit && dmxDirty)
+		commitDmx();
+	return 1;
+}
+
+
+int chkBaud(const unsigned int arg[], int n)
+{
+	return linkBrg(arg[0]) != 0;
+}
+
+
+int cmdBaud(const unsigned int arg[], int n)
+{
+	newBrg = linkBrg(arg[0]);		// Switch once 'Ready' went out
+	return 1;
+}
+
+
+int cmdPoll(const unsigned int arg[], int n)
+{
+	pollFlag = SEARCH_POLL;			// Set the pollFlag, the search runs in the main loop. Result comes when it is over.
+	return 1;
+}
+
+
+int cmdRdm(const unsigned int arg[], int n)
+{
+	pollFlag = SEARCH_RDM;			// RDM discovery, between the DMX frames like 'poll'
+	return 1;
+}
+
+
+int chkRdm(const unsigned int arg[], int n)	// A Device of the last 'rdm'
+{
+	return arg[0] >= 1 && arg[0] <= rdmctl_count() && arg[0] <= RDMCTL_DEVS;
+}
+
+
+int rdmRequest(int kind, const unsigned int arg[], int n)
+{
+	rdmArg[0] = arg[0];
+	rdmArg[1] = n > 1 ? arg[1] : 0;
+	rdmFlag = kind;
+	return 1;
+}
+
+
+int cmdRdmInfo(const unsigned int arg[], int n)
+{
+	return rdmRequest(RDM_INFO, arg, n);
+}
+
+
+int cmdRdmAddr(const unsigned int arg[], int n)
+{
+	return rdmRequest(RDM_ADDR, arg, n);
+}
+
+
+int cmdRdmId(const unsigned int arg[], int n)
+{
+	return rdmRequest(RDM_IDENTIFY, arg, n);
+}
+
+
+int chkMinRate(const unsigned int arg[], int n)
+{
+	return arg[0] <= RATE_MAX;
+}
+
+
+int cmdMinRate(const unsigned int arg[], int n)
+{
+	pollMinRate = arg[0];			// Frames per second kept while polling
+	return 1;
+}
+
+
+int cmdLegacy(const unsigned int arg[], int n)
+{
+	pollLegacy = arg[0];			// Old Devices only know the 0xF0 POLL
+	return 1;
+}
+
 
-	if(getInputChar())				// Get character form UART1. If it is CR then go to next step.
+int cmdHelp(const unsigned int arg[], int n)
+{
+	send_string(help);				// Send "HELP" string.
+	return 1;
+}
+
+
+//-----------------------------------------------------------------------------
+// Command table, sorted by verb for bsearch(). Argument letters:
+//   A address 1-512, D data 0-255, B 0 or 1, N any number 0-65535
+// A letter followed by '*' may repeat (one or more). 'check' (if any) looks
+// at what the letters can't tell, before anything of the line runs.
+//-----------------------------------------------------------------------------
+typedef struct
+{
+	const char *verb;
+	const char *args;
+	int (*check)(const unsigned int arg[], int n);
+	int (*handler)(const unsigned int arg[], int n);
+} CMD;
+
+const CMD cmdTable[] = {
+	{"auto",		"B",	0,				cmdAuto},
+	{"baud",		"N",	chkBaud,		cmdBaud},
+	{"brk",			"N",	chkBrk,			cmdBrk},
+	{"clear",		"",		0,				cmdClear},
+	{"commit",		"",		0,				cmdCommit},
+	{"copy",		"AAA",	chkCopy,		cmdCopy},
+	{"fill",		"AAD",	chkRange,		cmdFill},
+	{"floor",		"A",	0,				cmdFloor},
+	{"get",			"A",	0,				cmdGet},
+	{"help",		"",		0,				cmdHelp},
+	{"legacy",		"B",	0,				cmdLegacy},
+	{"mab",			"N",	chkMab,			cmdMab},
+	{"max",			"N",	chkMax,			cmdMax},
+	{"mbb",			"N",	chkMbb,			cmdMbb},
+	{"minrate",		"N",	chkMinRate,		cmdMinRate},
+	{"off",			"",		0,				cmdOff},
+	{"on",			"",		0,				cmdOn},
+	{"poll",		"",		0,				cmdPoll},
+	{"ramp",		"AADD",	chkRange,		cmdRamp},
+	{"rate",		"N",	chkRate,		cmdRate},
+	{"rdm",			"",		0,				cmdRdm},
+	{"rdmaddr",		"NA",	chkRdm,			cmdRdmAddr},
+	{"rdmid",		"NB",	chkRdm,			cmdRdmId},
+	{"rdminfo",		"N",	chkRdm,			cmdRdmInfo},
+	{"set",			"AD*",	chkSet,			cmdSet},
+	{"setrange",	"AAD*",	chkSetRange,	cmdSetRange},
+	{"stats",		"",		0,				cmdStats},
+};
+
+#define LINE_CMDS ((LINE_MAX+1)/3+1)	// Most cmds in a line ("on;on;...")
+const CMD *lineCmd[LINE_CMDS];		// Cmds of the line, run once all of them are fine
+unsigned int lineArg[LINE_CMDS+1];	// Where the numbers of each start in 'cmdArg'
+
+
+int cmdCompare(const void *verb, const void *cmd)
+{
+	return strcmp((const char *)verb, ((const CMD *)cmd)->verb);
+}
+
+
+//*********************************//
+// Is the number fine for 'letter' //
+//*********************************//
+int argFits(char letter, unsigned long num)
+{
+	switch(letter)
 	{
-		if(!parseStr())				// Start parsing. If there isn't any error, execute next step.
-	  	{
-			if(isCmd("set",3))		// Is it 'SET'?
-			{
-				if(type[1]=='n' && type[2]=='n') 	// Are both of the parameters number?
-				{
-					addr = getArgNum(1);
-					data = getArgNum(2);
-					if((addr>=1 && addr<=512) && (data>=0 && data<=255)) // Check if the parameters are within range
-						dmxData[addr] = data;
-					else 
-						invalidCmd = 1;
-				}
-				else invalidCmd = 1;				// Both parameters arent number. Error.
-			}
-			else if(isCmd("get",2))					// Is it 'GET' cmd?
-			{
-				if(type[1]=='n')					// Is the parameter a number?
-				{
-				   	addr = getArgNum(1);
-					if((addr>=1 && addr<=512))		// Check if the parameter is within range
-					{
-						itoa(buffer,dmxData[addr],10);
-						send_string("\r\n");
-						send_string(buffer);
-					}
-					else invalidCmd = 1;
-				}
-				else invalidCmd = 1;
-			}
-			else if(isCmd("max",2))					// Is it a 'MAX' cmd?
-			{
-				if(type[1]=='n')
-				{
-					addr = getArgNum(1);
-					if((addr>=1 && addr<=512)) 		// Check if the parameter is within range
-						maxDmxAddr = addr;
-					else 
-						invalidCmd = 1;
-				}
-				else invalidCmd = 1;
-			}
-			else if(isCmd("clear",1))				// Is it a 'CLEAR' cmd?
-			{
-				clrDmxData();
-			}
-			else if(isCmd("on",1))					// Is it a 'ON' cmd?
-			{
-				dmxOn = 1;							// Turn ON the DMX transmission.
-			}
-			else if(isCmd("off",1))					// Is it a 'OFF' cmd?
-			{
-				dmxOn = 0;							// Turn OFF the DMX transmission.
-			}
-			else if(isCmd("poll",1))
-			{
-				pollFlag = 1;						// Set the pollFlag, and execute after the end of ongoing DMX transmission. 
-			}
-			else if(isCmd("help",1))
-			{
-				send_string(help);					// Send "HELP" string.
-			}
-			else 
-				invalidCmd = 1;						// If nothing matches, certainly it is a invalid CMD
-			
-		}
-		else
+		case 'A': return num>=1 && num<=512;
+		case 'D': return num<=255;
+		case 'B': return num<=1;
+		case 'N': return num<=65535UL;
+	}
+	return 0;
+}
+
+
+//*******************************//
+// Nothing but delimiters in it? //
+//*******************************//
+int isBlank(const char str[])
+{
+	while(*str)
+	{
+		if(isalnum(*str++))
+			return 0;
+	}
+	return 1;
+}
+
+
+//*****************************************************//
+// Split one cmd, look it up & check it. 0 if invalid  //
+//-----------------------------------------------------//
+// Its numbers go to 'cmdArg' from 'at' on, 'at' ends  //
+// up behind them.                                     //
+//*****************************************************//
+const CMD *parseCmd(char str[], unsigned int *at)
+{
+	const CMD *cmd;
+	const char *spec;
+	char *verb;
+	unsigned long num;
+	unsigned int n = *at;			// Next free number
+	int got = 0;					// Numbers for the current letter
+
+	while(*str && !isalnum(*str))	// Anything else is a delimiter
+		str++;
+	if(!isalpha(*str))				// Cmd has to start with the verb
+		return 0;
+	verb = str;
+	while(isalpha(*str))
+		str++;
+	if(isdigit(*str))				// a -> n without delimiter. Error.
+		return 0;
+	if(*str)
+		*str++ = 0;
+
+	cmd = bsearch(verb, cmdTable, sizeof(cmdTable)/sizeof(cmdTable[0]), sizeof(CMD), cmdCompare);
+	if(!cmd)
+		return 0;
+
+	spec = cmd->args;
+	while(1)
+	{
+		while(*str && !isalnum(*str))
+			str++;
+		if(!*str)
+			break;
+		if(!isdigit(*str) || !*spec)	// Only numbers, and not more than asked for
+			return 0;
+
+		for(num=0;isdigit(*str);str++)
 		{
-			invalidCmd = 1;							// parseStr return error!
+			num = num*10 + (*str-'0');
+			if(num > 65535UL)
+				return 0;
 		}
-
-		if(invalidCmd)								// If the cmd is invalid send error msg. 
+		if(isalpha(*str))			// n -> a without delimiter. Error.
+			return 0;
+		if(!argFits(*spec,num) || n == sizeof(cmdArg)/sizeof(cmdArg[0]))
+			return 0;
+		cmdArg[n++] = num;
+		got++;
+
+		if(spec[1] != '*')			// Next letter, unless this one repeats
 		{
-			send_string(errMsg);
-			invalidCmd = 0;
+			spec++;
+			got = 0;
 		}
-		else if (!invalidCmd)			// Don't send READY if it is POLL
+	}
+	if(*spec && !(spec[1] == '*' && got > 0 && spec[2] == 0))	// Numbers missing?
+		return 0;
+	if(cmd->check && !cmd->check(cmdArg+*at, n-*at))
+		return 0;
+
+	*at = n;
+	return cmd;
+}
+
+
+//**************************************//
+// Read user data & process accordingly //
+//**************************************//
+void processCmd(char line[])		// Complete line from the UART1 Rx interrupt
+{
+	char *next;
+	int invalidCmd = 0, count = 0, i;
+	unsigned int at = 0;
+
+	while(line && !invalidCmd)		// Cmds are separated by ';'
+	{
+		next = strchr(line,';');
+		if(next)
+			*next++ = 0;
+
+		if(!isBlank(line))			// Skip empty ones
 		{
-			grnTimeout = 250;
-			LATBbits.LATB4 = 1;
-			if(!pollFlag)
-				send_string(ready);
+			lineArg[count] = at;
+			lineCmd[count] = parseCmd(line,&at);
+			invalidCmd = !lineCmd[count];
+			count++;
 		}
+		line = next;
+	}
+	lineArg[count] = at;
+	if(count == 0)
+		invalidCmd = 1;
+
+	for(i=0;i<count && !invalidCmd;i++)	// All of them are fine: run them in order
+		invalidCmd = !lineCmd[i]->handler(cmdArg+lineArg[i], lineArg[i+1]-lineArg[i]);
+
+	if(invalidCmd)								// If the cmd is invalid send error msg. 
+	{
+		send_string(errMsg);
+	}
+	else
+	{
+		grnTimeout = 250;
+		LATBbits.LATB4 = 1;
+		send_string(ready);						// POLL results follow later
 	}
 }
 
 
+//********************************************//
+// Execute a binary frame & reply accordingly //
+//********************************************//
+void processBin(int kind, const unsigned char frame[])	// Opcode, length, payload
+{
+	unsigned char op = frame[0], err = 0, errData[2];
+	const unsigned char *data = frame+3;
+	unsigned int len = BIN_WORD(frame+1), addr, n;
+
+	if(kind == MSG_BAD)
+		err = BIN_ERR_CHECKSUM;
+	else if(op == BIN_UNIVERSE)				// Slots 1..len, 'max' stays as it is
+	{
+		if(len>=1 && len<=512)
+		{
+			memcpy(dmxtx_getBuf()+1,data,len);
+			slotsWritten(1,len);
+		}
+		else err = BIN_ERR_RANGE;
+	}
+	else if(op == BIN_WRITE)				// Slots from an address on
+	{
+		addr = BIN_WORD(data);
+		n = len-2;
+		if(len>2 && addr>=1 && addr+n-1<=512)
+		{
+			memcpy(dmxtx_getBuf()+addr,data+2,n);
+			slotsWritten(addr,addr+n-1);
+		}
+		else err = BIN_ERR_RANGE;
+	}
+	else if(op == BIN_READ)					// Latest values, committed or not
+	{
+		addr = BIN_WORD(data);
+		n = BIN_WORD(data+2);
+		if(len==4 && addr>=1 && n>=1 && addr+n-1<=512)
+			binlink_send2(BIN_READ|BIN_REPLY,addr,dmxtx_getBuf()+addr,n);
+		else err = BIN_ERR_RANGE;
+	}
+	else if(op == BIN_COMMIT)
+	{
+		commitDmx();
+	}
+	else if(op == BIN_MAX)					// Frame length, as 'max'
+	{
+		addr = BIN_WORD(data);
+		if(len==2 && chkMax(&addr,1))
+			cmdMax(&addr,1);
+		else err = BIN_ERR_RANGE;
+	}
+	else err = BIN_ERR_OPCODE;
+
+	if(err)
+	{
+		errData[0] = op;
+		errData[1] = err;
+		binlink_send(BIN_ERROR,errData,2);
+	}
+	else
+	{
+		if(op != BIN_READ)					// Read has its reply already
+			binlink_send(op|BIN_REPLY,0,0);
+		grnTimeout = 250;
+		LATBbits.LATB4 = 1;
+	}
+}
@@ -0,0 +1,83 @@
+/*! \file rdm.h \brief RDM (ANSI E1.20) packets. */
+//*****************************************************************************
+//
+// File Name	: 'rdm.h'
+// Title		: RDM packets
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __RDM_H__
+ #define __RDM_H__
+
+
+#define RDM_SC 0xCC					// Start code
+#define RDM_SUB_SC 0x01				// Sub start code (message format)
+
+// Offsets in a packet
+#define RDM_LEN 2					// Message length: start code to the end of the data
+#define RDM_DEST 3
+#define RDM_SRC 9
+#define RDM_TN 15					// Transaction number
+#define RDM_PORT 16					// Port ID, response type in a response
+#define RDM_MSGS 17					// Message count
+#define RDM_SUBDEV 18
+#define RDM_CC 20					// Command class
+#define RDM_PID 21
+#define RDM_PDL 23
+#define RDM_PD 24					// Parameter data
+
+#define RDM_UID_LEN 6
+#define RDM_PD_MAX 231
+#define RDM_PKT_MAX (RDM_PD+RDM_PD_MAX+2)	// With checksum
+#define RDM_DUB_LEN 24				// Answer to DISC_UNIQUE_BRANCH, preamble included
+
+// Command classes
+#define RDM_DISC 0x10
+#define RDM_DISC_RESP 0x11
+#define RDM_GET 0x20
+#define RDM_GET_RESP 0x21
+#define RDM_SET 0x30
+#define RDM_SET_RESP 0x31
+
+// Parameter IDs
+#define RDM_PID_DUB 0x0001			// DISC_UNIQUE_BRANCH
+#define RDM_PID_MUTE 0x0002
+#define RDM_PID_UNMUTE 0x0003
+#define RDM_PID_DEVINFO 0x0060
+#define RDM_PID_ADDR 0x00F0			// DMX_START_ADDRESS
+#define RDM_PID_IDENTIFY 0x1000
+
+#define RDM_DEVINFO_LEN 19
+
+// Response types and NACK reasons
+#define RDM_ACK 0x00
+#define RDM_ACK_TIMER 0x01
+#define RDM_NACK 0x02
+#define RDM_NR_UNKNOWN_PID 0x0000
+#define RDM_NR_FORMAT 0x0001
+#define RDM_NR_CC 0x0005			// Unsupported command class
+#define RDM_NR_RANGE 0x0006			// Data out of range
+#define RDM_NR_SUB_DEVICE 0x0009	// Sub-device out of range
+
+#define RDM_MANUF 0x7FF0			// ESTA prototype range, until there is a real ID
+
+
+//Functions
+unsigned int rdm_build(unsigned char pkt[], const unsigned char dest[], const unsigned char src[],
+		unsigned char tn, unsigned char port, unsigned char cc, unsigned int pid,
+		const unsigned char pd[], unsigned char pdl);
+int rdm_check(const unsigned char pkt[], unsigned int n);
+int rdm_complete(const unsigned char buf[], unsigned int n);
+unsigned int rdm_pid(const unsigned char pkt[]);
+unsigned int rdm_dubBuild(unsigned char out[], const unsigned char uid[]);
+int rdm_dubDecode(const unsigned char in[], unsigned int n, unsigned char uid[]);
+int rdm_forUid(const unsigned char dest[], const unsigned char uid[]);
+int rdm_broadcast(const unsigned char dest[]);
+unsigned long long rdm_uidNum(const unsigned char uid[]);
+void rdm_uidSet(unsigned char uid[], unsigned long long num);
+
+#endif
@@ -0,0 +1,257 @@
+/*! \file rdmctl.c \brief RDM controller: discovery, GET and SET. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'rdmctl.c'
+// Title		: RDM controller
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    Timer2 (through timebase.c)
+
+// The bus is reached through the 'xfer' function given to rdmctl_init(): it
+// sends a request (Break, MAB, then the packet) and returns what came back,
+// the Break left out. 0 if nothing came.
+//
+// Discovery is the one of E1.20: all Devices are unmuted, then
+// DISC_UNIQUE_BRANCH asks every unmuted Device with a UID in a branch to
+// answer. A clean answer is muted and the same branch asked again. A
+// spoilt answer (collision) splits the branch in two. Branches still to be
+// asked are kept on a stack like in discover.c, and rdmctl_step() does one
+// branch so the caller can keep the DMX frames going in between.
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include <string.h>
+#include "rdmctl.h"
+#include "timebase.h"
+
+
+#define UID_MAX 0xFFFFFFFFFFFEULL	// Highest UID which is not a broadcast
+#define PORT_ID 1					// Our only port
+
+
+unsigned int (*ctlXfer)(const unsigned char req[], unsigned int len, unsigned char resp[]);
+unsigned char ctlUid[RDM_UID_LEN];	// Our own UID
+unsigned char ctlTn = 0;			// Transaction number
+unsigned char ctlReq[RDM_PKT_MAX];
+unsigned char ctlResp[RDM_PKT_MAX];
+unsigned int ctlNack;				// Reason of the last NACK
+
+// Open branches
+unsigned long long stackLo[RDMCTL_STACK];
+unsigned long long stackHi[RDMCTL_STACK];
+int ctlTop = 0;
+int ctlUnmute = 0;					// Search starts with unmuting everyone
+
+// Results
+unsigned char ctlFound[RDMCTL_DEVS][RDM_UID_LEN];
+unsigned int ctlCount = 0;			// May be more than RDMCTL_DEVS, the rest isn't kept
+unsigned int ctlXfers = 0;
+unsigned long ctlTicks = 0;			// Time stamp ticks spent on the bus
+unsigned long ctlWorst = 0;			// Longest branch
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void rdmctl_init(unsigned int (*xfer)(const unsigned char req[], unsigned int len, unsigned char resp[]),
+		const unsigned char uid[])
+{
+	ctlXfer = xfer;
+	memcpy(ctlUid, uid, RDM_UID_LEN);
+	ctlTop = 0;
+	ctlUnmute = 0;
+	ctlCount = 0;
+}
+
+
+// One request and its answer. Returns the length of the answer in 'ctlResp'.
+static unsigned int rdmctl_xfer(const unsigned char dest[], unsigned char cc, unsigned int pid,
+		const unsigned char pd[], unsigned int pdl)
+{
+	unsigned int len = rdm_build(ctlReq, dest, ctlUid, ++ctlTn, PORT_ID, cc, pid, pd, pdl);
+
+	ctlXfers++;
+	return ctlXfer(ctlReq, len, ctlResp);
+}
+
+
+// Request and check the answer. RDMCTL_OK with the parameter data in 'ctlResp'.
+static int rdmctl_ask(const unsigned char uid[], unsigned char cc, unsigned int pid,
+		const unsigned char pd[], unsigned int pdl)
+{
+	unsigned int n = rdmctl_xfer(uid, cc, pid, pd, pdl);
+
+	if(rdm_broadcast(uid))
+		return RDMCTL_OK;			// Nobody answers those
+	if(!n)
+		return RDMCTL_NOREPLY;
+	if(!rdm_check(ctlResp, n) || ctlResp[RDM_CC] != cc+1 || rdm_pid(ctlResp) != pid
+			|| ctlResp[RDM_TN] != ctlTn || memcmp(ctlResp+RDM_SRC, uid, RDM_UID_LEN)
+			|| memcmp(ctlResp+RDM_DEST, ctlUid, RDM_UID_LEN))
+		return RDMCTL_BAD;
+	if(ctlResp[RDM_PORT] == RDM_NACK)
+	{
+		ctlNack = ctlResp[RDM_PDL] >= 2 ? (ctlResp[RDM_PD] << 8) | ctlResp[RDM_PD+1] : 0;
+		return RDMCTL_NACK;
+	}
+	if(ctlResp[RDM_PORT] != RDM_ACK)
+		return RDMCTL_BAD;			// ACK_TIMER and overflow aren't used by our Devices
+	return RDMCTL_OK;
+}
+
+
+static void rdmctl_push(unsigned long long lo, unsigned long long hi)
+{
+	if(ctlTop < RDMCTL_STACK)
+	{
+		stackLo[ctlTop] = lo;
+		stackHi[ctlTop] = hi;
+		ctlTop++;
+	}
+}
+
+
+static void rdmctl_add(const unsigned char uid[])
+{
+	if(ctlCount < RDMCTL_DEVS)
+		memcpy(ctlFound[ctlCount], uid, RDM_UID_LEN);
+	ctlCount++;
+}
+
+
+// Forget the last results and start a new search
+void rdmctl_start(void)
+{
+	ctlCount = 0;
+	ctlXfers = 0;
+	ctlTicks = 0;
+	ctlWorst = 0;
+	ctlTop = 0;
+	rdmctl_push(0, UID_MAX);
+	ctlUnmute = 1;
+}
+
+
+// Ask the next branch. Returns RDMCTL_DONE once nothing is left to ask.
+int rdmctl_step(void)
+{
+	unsigned char all[RDM_UID_LEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+	unsigned char pd[2*RDM_UID_LEN], uid[RDM_UID_LEN];
+	unsigned long long lo, hi, found;
+	unsigned long start;
+	unsigned int n;
+
+	if(!ctlUnmute && !ctlTop)
+		return RDMCTL_DONE;
+
+	start = tb_now();
+	if(ctlUnmute)
+	{
+		ctlUnmute = 0;
+		rdmctl_ask(all, RDM_DISC, RDM_PID_UNMUTE, 0, 0);
+	}
+	else
+	{
+		ctlTop--;
+		lo = stackLo[ctlTop];
+		hi = stackHi[ctlTop];
+		rdm_uidSet(pd, lo);
+		rdm_uidSet(pd+RDM_UID_LEN, hi);
+		n = rdmctl_xfer(all, RDM_DISC, RDM_PID_DUB, pd, sizeof(pd));
+		if(n)						// Somebody is in the branch
+		{
+			found = rdm_dubDecode(ctlResp, n, uid) ? rdm_uidNum(uid) : ~0ULL;
+			if(found >= lo && found <= hi && rdmctl_ask(uid, RDM_DISC, RDM_PID_MUTE, 0, 0) == RDMCTL_OK)
+			{
+				rdmctl_add(uid);
+				rdmctl_push(lo, hi);	// Ask again, without it
+			}
+			else if(lo != hi)		// Collision, split the branch
+			{
+				rdmctl_push(lo + (hi-lo)/2 + 1, hi);
+				rdmctl_push(lo, lo + (hi-lo)/2);
+			}
+		}
+	}
+	start = tb_now() - start;
+	ctlTicks += start;
+	if(start > ctlWorst)
+		ctlWorst = start;
+	return RDMCTL_BUSY;
+}
+
+
+// Devices found by the last search (not all kept beyond RDMCTL_DEVS)
+unsigned int rdmctl_count(void)
+{
+	return ctlCount;
+}
+
+
+// UID of found Device 'i' (0 first), 0 if it isn't kept
+const unsigned char *rdmctl_uid(unsigned int i)
+{
+	return i < ctlCount && i < RDMCTL_DEVS ? ctlFound[i] : 0;
+}
+
+
+unsigned int rdmctl_xfers(void)
+{
+	return ctlXfers;
+}
+
+
+// Bus time of the last search
+unsigned long rdmctl_busUs(void)
+{
+	return ctlTicks / TB_PER_US;
+}
+
+
+// Longest step of the last search
+unsigned long rdmctl_worstUs(void)
+{
+	return ctlWorst / TB_PER_US;
+}
+
+
+// GET 'pid' of a Device. The answer's data goes to 'pd' (up to RDM_PD_MAX bytes).
+int rdmctl_get(const unsigned char uid[], unsigned int pid, unsigned char pd[], unsigned int *pdl)
+{
+	int result = rdmctl_ask(uid, RDM_GET, pid, 0, 0);
+
+	*pdl = 0;
+	if(result == RDMCTL_OK && !rdm_broadcast(uid))
+	{
+		*pdl = ctlResp[RDM_PDL];
+		memcpy(pd, ctlResp+RDM_PD, *pdl);
+	}
+	return result;
+}
+
+
+// SET 'pid' of a Device, or of all of them with a broadcast UID
+int rdmctl_set(const unsigned char uid[], unsigned int pid, const unsigned char pd[], unsigned int pdl)
+{
+	return rdmctl_ask(uid, RDM_SET, pid, pd, pdl);
+}
+
+
+// Reason of the last RDMCTL_NACK
+unsigned int rdmctl_nack(void)
+{
+	return ctlNack;
+}
@@ -0,0 +1,45 @@
+/*! \file rdmctl.h \brief RDM controller: discovery, GET and SET. */
+//*****************************************************************************
+//
+// File Name	: 'rdmctl.h'
+// Title		: RDM controller
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __RDMCTL_H__
+ #define __RDMCTL_H__
+
+#include "rdm.h"
+
+
+#define RDMCTL_DEVS 32				// UIDs kept from a search
+#define RDMCTL_STACK 52				// Open branches; a 48 bit UID space is split 48 times at most
+
+#define RDMCTL_DONE 0				// rdmctl_step() results
+#define RDMCTL_BUSY 1
+
+#define RDMCTL_OK 0					// GET and SET results
+#define RDMCTL_NOREPLY 1
+#define RDMCTL_BAD 2				// Spoilt or not the answer to the request
+#define RDMCTL_NACK 3				// Reason in rdmctl_nack()
+
+
+//Functions
+void rdmctl_init(unsigned int (*xfer)(const unsigned char req[], unsigned int len, unsigned char resp[]),
+		const unsigned char uid[]);
+void rdmctl_start(void);
+int rdmctl_step(void);
+unsigned int rdmctl_count(void);
+const unsigned char *rdmctl_uid(unsigned int i);
+unsigned int rdmctl_xfers(void);
+unsigned long rdmctl_busUs(void);
+unsigned long rdmctl_worstUs(void);
+int rdmctl_get(const unsigned char uid[], unsigned int pid, unsigned char pd[], unsigned int *pdl);
+int rdmctl_set(const unsigned char uid[], unsigned int pid, const unsigned char pd[], unsigned int pdl);
+unsigned int rdmctl_nack(void);
+
+#endif
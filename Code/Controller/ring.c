@@ -0,0 +1,172 @@
+/*! \file ring.c \brief Single producer, single consumer byte queue. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'ring.c'
+// Title		: Ring buffer
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    None
+
+// One side writes, the other one reads, one of them may be an interrupt.
+// No locking is needed: only the producer moves 'head', only the consumer
+// moves 'tail', and both are single word stores on the dsPIC. One slot stays
+// empty to tell full from empty.
+//
+// The producer can also build a block (a line, a frame) before the consumer
+// may see it: ring_pend() adds to it, ring_unpend() takes the last byte back
+// (backspace), ring_poke() fills in a header, and ring_publish() hands it
+// over in one go. ring_discard() throws the block away.
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include "ring.h"
+#include "hal.h"
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// 'size' must be a power of 2
+void ring_init(RING *r, unsigned char *buf, unsigned int size, void (*kick)(void))
+{
+	r->buf = buf;
+	r->mask = size - 1;
+	r->head = r->tail = r->put = 0;
+	r->kick = kick;
+	r->highWater = 0;
+	r->drops = 0;
+}
+
+
+// Bytes the consumer can read
+unsigned int ring_count(RING *r)
+{
+	return (r->head - r->tail) & r->mask;
+}
+
+
+// Bytes the producer can still add (pending ones count as used)
+unsigned int ring_free(RING *r)
+{
+	return (r->tail - r->put - 1) & r->mask;
+}
+
+
+// Add a byte to the pending block. Returns 0 (and counts a drop) if full.
+int ring_pend(RING *r, unsigned char data)
+{
+	if(ring_free(r) == 0)
+	{
+		r->drops++;
+		return 0;
+	}
+	r->buf[r->put] = data;
+	r->put = (r->put + 1) & r->mask;
+	return 1;
+}
+
+
+// Take the last pending byte back
+void ring_unpend(RING *r)
+{
+	if(r->put != r->head)
+		r->put = (r->put - 1) & r->mask;
+}
+
+
+unsigned int ring_pending(RING *r)
+{
+	return (r->put - r->head) & r->mask;
+}
+
+
+// Overwrite a pending byte, 'offset' from the start of the block
+void ring_poke(RING *r, unsigned int offset, unsigned char data)
+{
+	r->buf[(r->head + offset) & r->mask] = data;
+}
+
+
+// Hand the pending block to the consumer
+void ring_publish(RING *r)
+{
+	unsigned int used = (r->put - r->tail) & r->mask;
+
+	if(used > r->highWater)
+		r->highWater = used;
+	r->head = r->put;				// Bytes are in place before the consumer sees them
+	if(r->kick)
+		r->kick();
+}
+
+
+void ring_discard(RING *r)
+{
+	r->put = r->head;
+}
+
+
+// Queue 'len' bytes. Returns how many were queued.
+unsigned int ring_write(RING *r, const unsigned char *data, unsigned int len, int mode)
+{
+	unsigned int done = 0, room;
+
+	if(mode == RING_TRY && ring_free(r) < len)
+		return 0;
+
+	while(done < len)
+	{
+		room = ring_free(r);
+		if(room == 0)
+		{
+			if(mode != RING_BLOCK)
+			{
+				r->drops += len - done;
+				break;
+			}
+			while(ring_free(r) == 0)	// Consumer makes room
+				hal_spin();
+			continue;
+		}
+		while(room-- && done < len)
+		{
+			r->buf[r->put] = data[done++];
+			r->put = (r->put + 1) & r->mask;
+		}
+		ring_publish(r);			// Consumer can start on it while we wait
+	}
+	return done;
+}
+
+
+// Queue one byte, same modes. Returns 1 if it was queued.
+int ring_put(RING *r, unsigned char data, int mode)
+{
+	return ring_write(r, &data, 1, mode);
+}
+
+
+// Next byte, -1 if there is none
+int ring_get(RING *r)
+{
+	unsigned char data;
+
+	if(r->tail == r->head)
+		return -1;
+	data = r->buf[r->tail];
+	r->tail = (r->tail + 1) & r->mask;
+	return data;
+}
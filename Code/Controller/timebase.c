@@ -0,0 +1,79 @@
+/*! \file timebase.c \brief Free running time stamps. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'timebase.c'
+// Title		: Time stamps
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    Timer2
+
+// Timer2 counts Fcy/8 (0.2 us) over the full 16 bit range. Its interrupt
+// adds the upper 16 bits, so tb_now() gives a 32 bit stamp which wraps after
+// about 14 minutes. Differences of two stamps are always right as long as
+// they are computed with unsigned long arithmetic.
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include <p33FJ128MC802.h>
+#include "timebase.h"
+
+
+volatile unsigned int tbHigh = 0;	// Upper 16 bits of the time stamp
+
+
+//-----------------------------------------------------------------------------
+// Interrupt Subroutines
+//-----------------------------------------------------------------------------
+
+// For TIMER2 (overflow)
+void __attribute__((interrupt, no_auto_psv)) _T2Interrupt(void)
+{
+	tbHigh++;
+	IFS0bits.T2IF = 0;				// Clear the flag
+}
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void tb_init(void)
+{
+	T2CON = 0;
+	TMR2 = 0;
+	PR2 = 0xFFFF;					// Free running
+	T2CONbits.TCKPS = 1;			// Prescaler 8
+	IFS0bits.T2IF = 0;				// Clear the flag
+	IEC0bits.T2IE = 1;				// Enable timer 2 interrupts
+	T2CONbits.TON = 1;
+}
+
+
+// 32 bit time stamp in 0.2 us. Safe from main and from interrupts.
+unsigned long tb_now(void)
+{
+	unsigned int hi, lo;
+
+	do
+	{
+		hi = tbHigh;
+		lo = TMR2;
+	} while(hi != tbHigh);
+
+	if(IFS0bits.T2IF && lo < 0x8000)	// Overflow not counted yet (called with the
+		hi++;							// Timer2 interrupt held off)
+
+	return ((unsigned long)hi << 16) | lo;
+}
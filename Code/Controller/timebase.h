@@ -0,0 +1,24 @@
+/*! \file timebase.h \brief Free running time stamps. */
+//*****************************************************************************
+//
+// File Name	: 'timebase.h'
+// Title		: Time stamps
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __TIMEBASE_H__
+ #define __TIMEBASE_H__
+
+
+#define TB_PER_US 5					// Timer2 ticks per us (40 MHz / 8)
+
+
+//Functions
+void tb_init(void);
+unsigned long tb_now(void);
+
+#endif
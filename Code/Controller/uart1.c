@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "uart1.h"
+#include "hal.h"
 
 
 //-----------------------------------------------------------------------------
@@ -57,7 +58,8 @@ void uart1_puts(const char str[])
 //Print a character
 void uart1_putc(char data)
 {
-   while(U1STAbits.UTXBF);	// make sure buffer is empty
+   while(U1STAbits.UTXBF)	// make sure buffer is empty
+     hal_spin();
    U1TXREG = data;			// write character
 }
 
@@ -68,6 +70,7 @@ char uart1_getc()
   if (U1STAbits.OERR == 1)	// clear out any overflow error condition
     U1STAbits.OERR = 0;
   
-  while(!U1STAbits.URXDA);	// wait until character is ready
+  while(!U1STAbits.URXDA)	// wait until character is ready
+    hal_spin();
   return U1RXREG;
 }
@@ -0,0 +1,165 @@
+/*! \file dmxbrk.c \brief Timer driven DMX Break and MAB generator. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'dmxbrk.c'
+// Title		: Break and MAB generator
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    Timer3, RB6 (U2TX pin)
+
+// The U2TX pin (RP6) is taken away from the UART and driven low from its
+// port latch for the Break, then high for the MAB. Timer3 times both of them
+// and gives the pin back to the UART. dmxbrk_startAfter() holds the line at
+// mark for a while before the Break (mark between frames). Nothing waits in the meantime; the
+// 'done' function is called from the Timer3 interrupt after the MAB, so the
+// caller can start the start code from there.
+//
+// Needs IOLOCK clear, like the rest of the PPS set up in init_hw().
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include <p33FJ128MC802.h>
+#include "dmxbrk.h"
+
+
+#define TICKS_PER_US 40				// Timer3 runs at Fcy (40 MHz)
+#define RP_U2TX 5					// PPS output function number of U2TX
+
+#define txPin LATBbits.LATB6		// U2TX pin RB6 (pin 15)
+
+
+// Generator state
+#define BRK_IDLE 0
+#define BRK_MARK 1
+#define BRK_BREAK 2
+#define BRK_MAB 3
+
+volatile int brkState = BRK_IDLE;
+unsigned int brkTicks = BRK_DEF_US*TICKS_PER_US;
+unsigned int mabTicks = MAB_DEF_US*TICKS_PER_US;
+void (*brkCallback)(void);			// Called after MAB
+
+
+//-----------------------------------------------------------------------------
+// Interrupt Subroutines
+//-----------------------------------------------------------------------------
+
+// For TIMER3 (end of mark, end of Break, end of MAB)
+void __attribute__((interrupt, no_auto_psv)) _T3Interrupt(void)
+{
+	if(brkState == BRK_MARK)		// Mark before Break is over, Break
+	{
+		txPin = 0;
+		RPOR3bits.RP6R = 0;			// Pin follows LATB6 now
+		PR3 = brkTicks - 1;
+		brkState = BRK_BREAK;
+	}
+	else if(brkState == BRK_BREAK)	// Break is over, Mark After Break
+	{
+		txPin = 1;
+		PR3 = mabTicks - 1;
+		brkState = BRK_MAB;
+	}
+	else							// MAB is over, give the pin back to the UART
+	{
+		T3CONbits.TON = 0;
+		RPOR3bits.RP6R = RP_U2TX;
+		brkState = BRK_IDLE;
+		if(brkCallback)
+			brkCallback();
+	}
+
+	IFS0bits.T3IF = 0;				// Clear the flag
+}
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void dmxbrk_init(void)
+{
+	txPin = 1;						// Port latch idles high like the UART
+	TRISBbits.TRISB6 = 0;
+
+	T3CON = 0;						// Timer off, Fcy, prescaler 1
+	IFS0bits.T3IF = 0;				// Clear the flag
+	IEC0bits.T3IE = 1;				// Enable timer 3 interrupts
+}
+
+
+// Set Break and MAB length in us. Returns 0 if out of range (nothing changed).
+int dmxbrk_set(unsigned int brkUs, unsigned int mabUs)
+{
+	if(brkUs < BRK_MIN_US || brkUs > BRK_MAX_US || mabUs < MAB_MIN_US || mabUs > MAB_MAX_US)
+		return 0;
+
+	brkTicks = brkUs*TICKS_PER_US;	// Picked up by the next Break
+	mabTicks = mabUs*TICKS_PER_US;
+	return 1;
+}
+
+
+unsigned int dmxbrk_getBrk(void)
+{
+	return brkTicks/TICKS_PER_US;
+}
+
+
+unsigned int dmxbrk_getMab(void)
+{
+	return mabTicks/TICKS_PER_US;
+}
+
+
+// Start a Break. The UART must be done sending (TRMT).
+void dmxbrk_start(void (*done)(void))
+{
+	dmxbrk_startAfter(0, done);
+}
+
+
+// Hold the line at mark for 'markUs' (up to BRK_MAX_US), then start a Break.
+void dmxbrk_startAfter(unsigned int markUs, void (*done)(void))
+{
+	brkCallback = done;
+
+	if(markUs)
+	{
+		brkState = BRK_MARK;		// U2TX idles high, it keeps the pin meanwhile
+		TMR3 = 0;
+		PR3 = markUs*TICKS_PER_US - 1;
+		IFS0bits.T3IF = 0;
+		T3CONbits.TON = 1;
+		return;
+	}
+
+	brkState = BRK_BREAK;
+
+	txPin = 0;
+	RPOR3bits.RP6R = 0;				// Pin follows LATB6 now: Break starts
+
+	TMR3 = 0;
+	PR3 = brkTicks - 1;
+	IFS0bits.T3IF = 0;
+	T3CONbits.TON = 1;
+}
+
+
+// Is a mark, Break or MAB on the line?
+int dmxbrk_busy(void)
+{
+	return brkState != BRK_IDLE;
+}
@@ -0,0 +1,34 @@
+/*! \file dmxbrk.h \brief Timer driven DMX Break and MAB generator. */
+//*****************************************************************************
+//
+// File Name	: 'dmxbrk.h'
+// Title		: Break and MAB generator
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __DMXBRK_H__
+ #define __DMXBRK_H__
+
+
+#define BRK_MIN_US 92				// E1.11 minimums for a transmitter
+#define MAB_MIN_US 12
+#define BRK_MAX_US 1600				// Timer3 with prescaler 1 can't count further
+#define MAB_MAX_US 1600
+#define BRK_DEF_US 96				// Power up values
+#define MAB_DEF_US 20
+
+
+//Functions
+void dmxbrk_init(void);
+int dmxbrk_set(unsigned int brkUs, unsigned int mabUs);
+unsigned int dmxbrk_getBrk(void);
+unsigned int dmxbrk_getMab(void);
+void dmxbrk_start(void (*done)(void));
+void dmxbrk_startAfter(unsigned int markUs, void (*done)(void));
+int dmxbrk_busy(void);
+
+#endif
@@ -0,0 +1,307 @@
+/*! \file dmxrx.c \brief Interrupt driven DMX receiver. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'dmxrx.c'
+// Title		: DMX receiver
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    UART2 receiver
+
+// Every byte is taken in the UART2 receive interrupt, so the main loop has
+// nothing to watch. A Break shows up as a 0 with a frame error (FERR). The
+// byte after it is the start code, and 'start' (called from the interrupt)
+// says what the packet is for:
+//
+// DMXRX_MINE: the slots dmxrx_window() asked for are copied into a buffer,
+// and the rest of the frame is only counted. Once the frame is over, 'frame'
+// gets the buffer (still in the interrupt), so every output changes from
+// the same, complete frame. A frame is over with the next Break, or as soon
+// as it has as many slots as the last frame ended by a Break (512 at first)
+// and the window is full. A frame error or an overrun anywhere in the frame
+// throws it away; the outputs keep the last good one.
+//
+// DMXRX_ALL: the packet goes through a ring ('ring.c', the interrupt is the
+// producer) to the main loop. It finds it with dmxrx_packet(), reads it with
+// dmxrx_getc() and lets go of it with dmxrx_end(). Only the main loop moves
+// the read side: dmxrx_packet() skips what is left of an older packet,
+// dmxrx_end() the rest of this one. dmxrx_ok() tells whether everything
+// read so far belonged to that packet: a Break before the end, a byte the
+// ring had no room for or a frame error spoils it.
+//
+// DMA can't help here: the Break is only seen through FERR of a single byte
+// and packets have no fixed length.
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include <p33FJ128MC802.h>
+#include "dmxrx.h"
+#include "ring.h"
+#include "hal.h"
+
+
+#define QUEUE 64					// DMXRX_ALL ring, a power of 2
+
+
+// Receiver state
+#define RX_SKIP 0					// Wait for the next Break
+#define RX_CODE 1					// Break came, start code is next
+#define RX_MINE 2
+#define RX_ALL 3
+
+volatile int rxState = RX_SKIP;
+int (*rxStart)(unsigned char code);
+void (*rxFrame)(const unsigned char slots[], unsigned int n);
+
+// DMXRX_MINE
+unsigned int rxSlot;				// Slot number of the next byte
+unsigned int frameLen = DMXRX_SLOTS;	// Slots of the last frame ended by a Break
+int winFull;						// All of the window is in winBuf
+int rxCounting;						// Slots of this frame are counted up to the Break
+unsigned int winFirst = 1;			// Slots wanted
+unsigned int winLast = 1;
+unsigned char winBuf[DMXRX_WINDOW];
+
+// DMXRX_ALL
+unsigned char queue[QUEUE];
+RING rxRing;
+volatile unsigned int pktStart;		// Ring position of its first byte
+volatile unsigned int pktSeq;		// Counts DMXRX_ALL packets
+volatile int pktCode = -1;			// Start code, until the main loop takes it
+volatile int pktLost;				// A byte of the packet didn't make it
+unsigned int rdSeq;					// Packet the main loop is reading
+int rdBroken;
+
+volatile unsigned int rxErrors = 0;	// Frame errors in a packet and overruns, since power up
+volatile unsigned int rxDropped = 0;	// DMXRX_MINE frames thrown away for them
+
+
+//-----------------------------------------------------------------------------
+// Interrupt Subroutines
+//-----------------------------------------------------------------------------
+
+// Byte lost or broken: nothing of this packet counts
+static void rx_error(void)
+{
+	rxErrors++;
+	if(rxState == RX_MINE)
+		rxDropped++;
+	pktLost = 1;
+	rxCounting = 0;					// Its length says nothing
+	rxState = RX_SKIP;
+}
+
+
+// DMXRX_MINE frame is over and whole
+static void rx_frameDone(void)
+{
+	if(winFull)
+		rxFrame(winBuf, winLast-winFirst+1);
+	rxState = RX_SKIP;
+}
+
+
+// For UART2 receiver (a byte came)
+void __attribute__((interrupt, no_auto_psv)) _U2RXInterrupt(void)
+{
+	unsigned char data;
+	int ferr;
+
+	IFS1bits.U2RXIF = 0;			// Clear the flag first, the FIFO is emptied below
+	if(U2STAbits.OERR)				// FIFO was full, bytes are gone
+	{
+		U2STAbits.OERR = 0;			// Empties the FIFO, nothing left to read
+		rx_error();
+		return;
+	}
+
+	while(U2STAbits.URXDA)
+	{
+		ferr = U2STAbits.FERR;		// Belongs to the byte on top of the FIFO
+		data = U2RXREG;
+
+		if(ferr)
+		{
+			if(data == 0)			// Break
+			{
+				if(rxCounting)
+					frameLen = rxSlot-1;
+				if(rxState == RX_MINE)
+					rx_frameDone();
+				rxCounting = 0;
+				rxState = RX_CODE;
+			}
+			else					// Broken byte, the rest of the packet can't be trusted
+				rx_error();
+			continue;
+		}
+
+		switch(rxState)
+		{
+		case RX_CODE:
+			rxSlot = 1;
+			switch(rxStart(data))
+			{
+			case DMXRX_MINE:
+				winFull = 0;
+				rxCounting = 1;
+				rxState = RX_MINE;
+				break;
+			case DMXRX_ALL:
+				pktStart = rxRing.head;
+				pktLost = 0;
+				pktCode = data;
+				pktSeq++;
+				rxState = RX_ALL;
+				break;
+			default:
+				rxState = RX_SKIP;
+			}
+			break;
+
+		case RX_MINE:
+			if(rxSlot >= winFirst && rxSlot <= winLast)
+			{
+				winBuf[rxSlot-winFirst] = data;
+				if(rxSlot == winLast)
+					winFull = 1;
+			}
+			if((rxSlot >= frameLen && winFull) || rxSlot >= DMXRX_SLOTS)
+				rx_frameDone();		// As long as the last one, no need to wait for the Break
+			rxSlot++;
+			break;
+
+		case RX_SKIP:
+			rxSlot++;				// Frames may get longer: count on for frameLen
+			break;
+
+		case RX_ALL:
+			if(!ring_put(&rxRing, data, RING_NOBLOCK))
+				pktLost = 1;		// Main loop is too slow, counted in the ring
+			break;
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// After uart2_init(). 'start' gives the DMXRX_... policy of a start code,
+// 'frame' gets the window of a DMXRX_MINE packet. Both run in the interrupt.
+void dmxrx_init(int (*start)(unsigned char code), void (*frame)(const unsigned char slots[], unsigned int n))
+{
+	rxStart = start;
+	rxFrame = frame;
+	rxState = RX_SKIP;				// Never start in the middle of a packet
+	ring_init(&rxRing, queue, QUEUE, 0);
+
+	U2STAbits.URXISEL = 0;			// Interrupt on every byte
+	IFS1bits.U2RXIF = 0;
+	IEC1bits.U2RXIE = 1;
+}
+
+
+// Slots 'first' to first+count-1 go to 'frame' (count up to DMXRX_WINDOW).
+// Returns quietly if the window doesn't fit.
+void dmxrx_window(unsigned int first, unsigned int count)
+{
+	if(first < 1 || count < 1 || count > DMXRX_WINDOW || first+count-1 > DMXRX_SLOTS)
+		return;
+
+	IEC1bits.U2RXIE = 0;			// Not in the middle of a window
+	winFirst = first;
+	winLast = first+count-1;
+	if(rxState == RX_MINE)
+		rxState = RX_SKIP;			// This frame started with the old window
+	IEC1bits.U2RXIE = 1;
+}
+
+
+// Start code of a DMXRX_ALL packet which came since the last call, -1 if none
+int dmxrx_packet(void)
+{
+	int code;
+
+	IEC1bits.U2RXIE = 0;
+	code = pktCode;
+	pktCode = -1;
+	rdSeq = pktSeq;
+	if(code >= 0)
+		while(rxRing.tail != pktStart)
+			ring_get(&rxRing);		// Left over from an older packet
+	IEC1bits.U2RXIE = 1;
+
+	rdBroken = 0;
+	return code;
+}
+
+
+// Next byte of the packet. Waits for it; gives 0 once the packet is over.
+unsigned char dmxrx_getc(void)
+{
+	int data;
+
+	while((data = ring_get(&rxRing)) < 0)
+	{
+		if(rxState != RX_ALL || pktSeq != rdSeq)
+		{
+			rdBroken = 1;			// Ended before it was read
+			return 0;
+		}
+		hal_spin();
+	}
+	return data;
+}
+
+
+// Was everything read so far from this packet, and nothing lost?
+int dmxrx_ok(void)
+{
+	return !rdBroken && !pktLost && pktSeq == rdSeq;
+}
+
+
+// Done with the packet, drop the rest of it
+void dmxrx_end(void)
+{
+	IEC1bits.U2RXIE = 0;
+	if(pktSeq == rdSeq)				// Nothing of a newer packet in the ring
+	{
+		if(rxState == RX_ALL)
+			rxState = RX_SKIP;
+		while(ring_get(&rxRing) >= 0);
+	}
+	IEC1bits.U2RXIE = 1;
+}
+
+
+unsigned int dmxrx_errors(void)
+{
+	return rxErrors;
+}
+
+
+unsigned int dmxrx_dropped(void)
+{
+	return rxDropped;
+}
+
+
+// DMXRX_ALL ring, for its drops and high water mark
+const RING *dmxrx_ring(void)
+{
+	return &rxRing;
+}
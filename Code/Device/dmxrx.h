@@ -0,0 +1,40 @@
+/*! \file dmxrx.h \brief Interrupt driven DMX receiver. */
+//*****************************************************************************
+//
+// File Name	: 'dmxrx.h'
+// Title		: DMX receiver
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __DMXRX_H__
+ #define __DMXRX_H__
+
+#include "ring.h"
+
+#define DMXRX_SLOTS 512				// Slots after the start code
+#define DMXRX_WINDOW 32				// Most slots captured from one frame
+
+// Slot policies, returned by the 'start' function
+#define DMXRX_SKIP 0				// Nothing wanted up to the next Break
+#define DMXRX_MINE 1				// The window goes to 'frame'
+#define DMXRX_ALL 2					// The main loop reads the packet
+
+
+//Functions
+void dmxrx_init(int (*start)(unsigned char code), void (*frame)(const unsigned char slots[], unsigned int n));
+void dmxrx_window(unsigned int first, unsigned int count);
+
+int dmxrx_packet(void);
+unsigned char dmxrx_getc(void);
+int dmxrx_ok(void);
+void dmxrx_end(void);
+
+unsigned int dmxrx_errors(void);
+unsigned int dmxrx_dropped(void);
+const RING *dmxrx_ring(void);
+
+#endif
@@ -0,0 +1,127 @@
+/*! \file fixture.c \brief Fixture personalities of the Device. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'fixture.c'
+// Title		: Fixture personalities
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    PWM outputs (through pwm.c)
+
+// A personality is a footprint (slots from the Device address on) and, for
+// every PWM output, the slot driving it. A 16 bit output takes its coarse
+// slot and the fine slot after it; an 8 bit one repeats the coarse byte as
+// fine, so 255 is full on either way. The tables are const and built by the
+// OUT_ macros, nothing is worked out at run time. fixture_frame() sets
+// every output of one personality from the same captured frame, then lets
+// pwm.c fade all of them to it together.
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include "fixture.h"
+#include "pwm.h"
+
+
+#define NO_SLOT 0xFF
+
+// Output driven by slot 'c' (from the Device address, 0 first)
+#define OUT_8(c)	{(c), NO_SLOT}
+#define OUT_16(c)	{(c), (c)+1}
+#define OUT_OFF		{NO_SLOT, NO_SLOT}
+
+
+typedef struct
+{
+	unsigned char coarse;			// Slot of the high byte, NO_SLOT: output stays off
+	unsigned char fine;				// Slot of the low byte, NO_SLOT: 8 bit
+} FIX_OUT;
+
+typedef struct
+{
+	const char *name;
+	unsigned char footprint;
+	FIX_OUT out[PWM_OUTPUTS];
+} PERSONALITY;
+
+
+const PERSONALITY personalities[FIX_COUNT] = {
+	{"Dimmer",			1,	{OUT_8(0),	OUT_OFF,	OUT_OFF,	OUT_OFF}},
+	{"RGB",				3,	{OUT_8(0),	OUT_8(1),	OUT_8(2),	OUT_OFF}},
+	{"RGBW",			4,	{OUT_8(0),	OUT_8(1),	OUT_8(2),	OUT_8(3)}},
+	{"Dimmer 16 bit",	2,	{OUT_16(0),	OUT_OFF,	OUT_OFF,	OUT_OFF}},
+	{"RGB 16 bit",		6,	{OUT_16(0),	OUT_16(2),	OUT_16(4),	OUT_OFF}},
+	{"RGBW 16 bit",		8,	{OUT_16(0),	OUT_16(2),	OUT_16(4),	OUT_16(6)}},
+};
+
+const PERSONALITY *fix = &personalities[FIX_DIMMER];
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Use personality 'pers' (FIX_...). Returns 0 if there is no such one.
+int fixture_select(unsigned int pers)
+{
+	unsigned int i;
+
+	if(pers >= FIX_COUNT)
+		return 0;
+	fix = &personalities[pers];
+	for(i=0;i<PWM_OUTPUTS;i++)		// Outputs it doesn't use go off
+		if(fix->out[i].coarse == NO_SLOT)
+			pwm_set(i, 0);
+	pwm_frame();
+	return 1;
+}
+
+
+unsigned int fixture_personality(void)
+{
+	return fix - personalities;
+}
+
+
+unsigned int fixture_footprint(void)
+{
+	return fix->footprint;
+}
+
+
+const char *fixture_name(unsigned int pers)
+{
+	return pers < FIX_COUNT ? personalities[pers].name : "";
+}
+
+
+// 'n' slots from the Device address on; slots past the end of the frame count as 0
+void fixture_frame(const unsigned char slots[], unsigned int n)
+{
+	const FIX_OUT *o;
+	unsigned int i, hi, lo;
+
+	for(i=0;i<PWM_OUTPUTS;i++)
+	{
+		o = &fix->out[i];
+		if(o->coarse == NO_SLOT)
+			continue;
+		hi = o->coarse < n ? slots[o->coarse] : 0;
+		if(o->fine == NO_SLOT)
+			lo = hi;
+		else
+			lo = o->fine < n ? slots[o->fine] : 0;
+		pwm_set(i, (hi << 8) | lo);
+	}
+	pwm_frame();
+}
@@ -0,0 +1,36 @@
+/*! \file fixture.h \brief Fixture personalities of the Device. */
+//*****************************************************************************
+//
+// File Name	: 'fixture.h'
+// Title		: Fixture personalities
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __FIXTURE_H__
+ #define __FIXTURE_H__
+
+
+// Personalities
+#define FIX_DIMMER 0				// 1 slot, OC1
+#define FIX_RGB 1					// 3 slots, OC1 to OC3
+#define FIX_RGBW 2					// 4 slots, OC1 to OC4
+#define FIX_DIMMER16 3				// Coarse, fine: OC1
+#define FIX_RGB16 4					// 3 coarse/fine pairs: OC1 to OC3
+#define FIX_RGBW16 5				// 4 coarse/fine pairs: OC1 to OC4
+#define FIX_COUNT 6
+
+#define FIX_FOOTPRINT_MAX 8			// Most slots of any personality
+
+
+//Functions
+int fixture_select(unsigned int pers);
+unsigned int fixture_personality(void);
+unsigned int fixture_footprint(void);
+const char *fixture_name(unsigned int pers);
+void fixture_frame(const unsigned char slots[], unsigned int n);
+
+#endif
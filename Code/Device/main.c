@@ -24,7 +24,7 @@ Version		: 1.0
 Target uC	: 33FJ128MC802
 Clock Source: 8 MHz primary oscillator set in configuration bits
 Clock Rate	: 80 MHz using prediv=2, plldiv=40, postdiv=2
-Devices used: UART
+Devices used: UART, Timer1, Timer2, Timer3, OC1-OC4, Change Notification
 
 -----------------------------------------------------------------------------
 Objective             
@@ -40,29 +40,57 @@ grounded.
 Red LED: anode connected through 100ohm resistor to RB5 (pin 14), cathode 
 grounded.
 
+PWM outputs: OC1 on RB2 (pin 6), OC2 on RB0 (pin 4), OC3 on RB1 (pin 5).
+OC4 runs, but has no free pin on this board.
+
 Device Address: RB3,RA4,RB9-RB15 are connected with 9 pin Dip switch. 
+They are read again only when a Change Notification interrupt says one of
+them moved.
 
 */
 
 
 #include <p33FJ128MC802.h>
 #include <stdio.h>
+#include <string.h>
 #include "uart2.h"
+#include "dmxbrk.h"
+#include "dmxrx.h"
+#include "pwm.h"
+#include "fixture.h"
+#include "rdmresp.h"
+#include "hal.h"
 
 
-#define dmxWrOn LATBbits.LATB8			 	// RS485 Read/Write Enable Pin RB8 (pin17)
 #define BAUD_250K 9							// UART2-->(40M/16/250K)-1
-#define BAUD_96153 25						// UART2-->(40M/16/96513)-1 
-											// For Break & MAB. This baudrate will give 20us MAB and 92us Break 
+#define RDM_DEV_ID 0x00000001UL				// RDM serial number, give every board its own
+#define RDM_TURN_US 180						// E1.20: answer no sooner than 176us after the request
+#define DIP_SETTLE_MS 20					// DIP switches bounce this long
+#define DEV_PERSONALITY FIX_DIMMER			// What the board drives, see fixture.h
 
 
-//-------- Delay functions --------//
-extern void wait_us(unsigned int n);
-extern void wait_ms(unsigned int n);
+// Start code table entry
+typedef struct
+{
+	unsigned char code;				// Start code
+	unsigned char slots;			// DMXRX_...
+	void (*start)(void);			// DMXRX_ALL: reads the packet, from the main loop
+	void (*frame)(const unsigned char slots[], unsigned int n);	// DMXRX_MINE: footprint from the Device address on, from the interrupt
+	unsigned int frames;			// Packets seen with this start code
+} START_CODE;
 
 
 // Global Variables
 unsigned int devAdd;			// Device Address Variable
+unsigned char dmxData[FIX_FOOTPRINT_MAX];	// Last DMX values of this Device
+START_CODE *rxCode;				// Start code of the packet coming in
+unsigned int otherFrames = 0;	// Packets with start codes not in the table
+volatile int addrChanged;		// DIP switches settled on a new address
+const unsigned char devUid[RDM_UID_LEN] = {RDM_MANUF >> 8, RDM_MANUF & 0xFF,
+		RDM_DEV_ID >> 24, (RDM_DEV_ID >> 16) & 0xFF, (RDM_DEV_ID >> 8) & 0xFF, RDM_DEV_ID & 0xFF};
+RDM_RESP rdmDev;				// RDM state: start address, mute, identify
+unsigned char rdmReq[RDM_PKT_MAX];
+unsigned char rdmResp[RDM_PKT_MAX];
 
 
 // Debug Variable
@@ -70,6 +98,7 @@ unsigned char dataOf512;
 
 // Timer1 Interrupt Variables
 volatile int redTimeout,grnTimeout,noDataTimeout;		// LED blink and Invalid DMX timeout variables.
+volatile int dipTimeout;		// DIP switch debounce
 
 
 //-----------------------------------------------------------------------------
@@ -97,11 +126,25 @@ void __attribute__((interrupt, no_auto_psv)) _T1Interrupt (void)
 		noDataTimeout--;
 		if(noDataTimeout <= 0) LATBbits.LATB4 = 0;
 	}
+
+	if(dipTimeout>0)
+	{
+		dipTimeout--;
+		if(dipTimeout <= 0) addrChanged = 1;
+	}
 	// clear IF
 	IFS0bits.T1IF = 0;
  }
 
 
+// For Change Notification (a DIP switch moved)
+void __attribute__((interrupt, no_auto_psv)) _CNInterrupt(void)
+{
+	dipTimeout = DIP_SETTLE_MS;		// Read the address once they stopped bouncing
+	IFS1bits.CNIF = 0;
+}
+
+
 //-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
 // Subroutines                
 //-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-~-
@@ -128,6 +171,11 @@ void init_hw()
   CNPU1 |= 0xF881;							// Enable pull-up for DIP Switch 
   CNPU2bits.CN16PUE = 1;
   CNPU2bits.CN21PUE = 1;		 
+  CNEN1 |= 0xF881;							// Change Notification on the same pins
+  CNEN2bits.CN16IE = 1;
+  CNEN2bits.CN21IE = 1;
+  IFS1bits.CNIF = 0;
+  IEC1bits.CNIE = 1;
 
   LATBbits.LATB8 = 0;						 // Write 0 into RB8 output latche
   TRISBbits.TRISB8 = 0;                      // Make DEn pin an output
@@ -135,31 +183,11 @@ void init_hw()
   RPOR3bits.RP6R = 5;                        // Assign U2TX to RP6
 
   RPOR1bits.RP2R = 18;                       // connect OC1 to RP2 (PWM)
+  RPOR0bits.RP0R = 19;                       // connect OC2 to RP0
+  RPOR0bits.RP1R = 20;                       // connect OC3 to RP1
 }
 
 
-void pwm_init()
-{
-  // Clock timer 2 with internal 40 MHz clock
-  // and set period to 1.63ms
-  T2CONbits.TCS = 0;	// Select Fcy
-  T2CONbits.TCKPS = 3;	// Prescaler 256
-  T2CONbits.TON = 1;
-  PR2 = 255;
-  
-  OC1CON = 0;			// turn-off OC1 to make sure changes can be applied
-  OC1R = 0;				// set first cycle d.c.
-  OC1RS = 0;			// set ongoing d.c. to 0
-  OC1CONbits.OCTSEL = 0;// Select Timer 2 as source
-  OC1CONbits.OCM = 6;	// Set OC1 to PWM mode
-}
-
-
-void pwm_setdc(unsigned int dc)
-{
-  OC1RS = dc;
-}
-
 //*******************//
 // Initialize Timer1 //
 //*******************//
@@ -192,20 +220,52 @@ void readDevAdd()
 }
 
 
+//************************************************//
+// Send the device address after the poll Break   //
+//------------------------------------------------//
+// 0xAA, then address and checksum (high bytes    //
+// first), every byte twice: OR 0xAA, then OR     //
+// 0x55. Checksum is the sum of the address bytes //
+// on the wire. A collision spoils the checksum.  //
+//************************************************//
+void sendAddr()
+{
+	unsigned char enc[4];
+	unsigned int sum = 0;
+	int i;
+
+	enc[0] = (devAdd >> 8) | 0xAA;
+	enc[1] = (devAdd >> 8) | 0x55;
+	enc[2] = (devAdd & 0xFF) | 0xAA;
+	enc[3] = (devAdd & 0xFF) | 0x55;
+
+	uart2_putc(0xAA);				// Separator
+	for(i=0;i<4;i++)
+	{
+		uart2_putc(enc[i]);
+		sum += enc[i];
+	}
+	uart2_putc((sum >> 8) | 0xAA);
+	uart2_putc((sum >> 8) | 0x55);
+	uart2_putc((sum & 0xFF) | 0xAA);
+	uart2_putc((sum & 0xFF) | 0x55);
+}
+
+
 //*******************************//
 // DMX Break generation function //
 //*******************************//
 void brkFunc()
 {
 	// Initiating BREAK and MAB
-	while(!U2STAbits.TRMT);			// Wait till Tx buffer empty		
+	while(!U2STAbits.TRMT) hal_spin();	// Wait till Tx buffer empty		
 	dmxWrOn = 1;					// DMX Write Enable
-	U2BRG = BAUD_96153;				// Slow the Baud Rate 
-	uart2_putc(0);					// Sending Break and MAB
-	while(!U2STAbits.TRMT);			// Wait till Brk & MAB transmitted
-	// Break and MAB end
-			
-	U2BRG = BAUD_250K;				// Return to default speed.
+	dmxbrk_start(0);				// Timer3 makes Break and MAB
+	while(dmxbrk_busy()) hal_spin();	// Address has to follow the MAB
+
+	sendAddr();
+	while(!U2STAbits.TRMT) hal_spin();	// Wait till the address is out
+	dmxWrOn = 0; 					// DMX Read On
 }
 
 
@@ -215,11 +275,11 @@ void brkFunc()
 int retriveData()
 {
 	unsigned int index = 1;		// Index Variable for DMX buffer
-   	unsigned char data,temp;	
+   	unsigned char data = 0,temp;	
 
 	while(index<513)			// Read all 512 data
 	{
-		temp = uart2_getc();
+		temp = dmxrx_getc();
 		if(index == devAdd)		// Is the data is for this device?
 		{
 			data = temp;	
@@ -235,6 +295,210 @@ int retriveData()
 }
 
 
+//**********************************************//
+// Retrive the windowed poll (start code 0xF1)  //
+//----------------------------------------------//
+// min, max (low byte first), then one bit per  //
+// address in the window, set for found devices //
+//**********************************************//
+int retriveWindow()
+{
+	unsigned int min, max, i;
+	unsigned char mask;
+	int answer = 0;
+
+	min = dmxrx_getc();
+	min |= dmxrx_getc() << 8;
+	max = dmxrx_getc();
+	max |= dmxrx_getc() << 8;
+	if(min < 1 || max > 512 || min > max)
+		return 0;				// Not a window, rest of it is dropped
+
+	for(i=min;i<=max;i+=8)		// Read the whole mask, answer only after it
+	{
+		mask = dmxrx_getc();
+		if(devAdd >= i && devAdd < i+8 && devAdd <= max)
+			answer = !((mask >> (devAdd-i)) & 1);	// In the window and not found yet
+	}
+
+	return answer;
+}
+
+
+
+//**********************************************//
+// RDM request (start code 0xCC), answer to it  //
+//----------------------------------------------//
+// Nothing goes out for a broadcast, a request  //
+// for another device or a spoilt packet.       //
+//**********************************************//
+void rdmAnswer()
+{
+	unsigned int i, len;
+	int brk;
+
+	rdmReq[0] = RDM_SC;
+	rdmReq[1] = dmxrx_getc();		// Sub start code
+	rdmReq[2] = dmxrx_getc();		// Message length, checksum comes after it
+	len = rdmReq[RDM_LEN] + 2;
+	if(rdmReq[1] != RDM_SUB_SC || len < RDM_PD+2)
+		return;						// Not a packet we know, rest of it is dropped
+	for(i=3;i<len;i++)
+		rdmReq[i] = dmxrx_getc();
+	if(!dmxrx_ok())
+		return;						// Cut short by a Break or a lost byte
+
+	len = rdmresp_handle(&rdmDev, rdmReq, len, rdmResp, &brk);
+	dmxrx_end();					// Nothing more to read, keep the receiver quiet meanwhile
+	if(!len)
+		return;
+
+	wait_us(RDM_TURN_US);			// Controller needs the time to turn the bus around
+	dmxWrOn = 1;					// DMX Write Enable
+	if(brk)							// Only the DISC_UNIQUE_BRANCH answer has no Break
+	{
+		dmxbrk_start(0);
+		while(dmxbrk_busy()) hal_spin();
+	}
+	for(i=0;i<len;i++)
+		uart2_putc(rdmResp[i]);
+	while(!U2STAbits.TRMT) hal_spin();	// Wait till the answer is out
+	dmxWrOn = 0; 					// DMX Read On
+}
+
+
+//********************************************//
+// DMX data (start code 0x00) for this Device //
+//********************************************//
+void dmxFrame(const unsigned char slots[], unsigned int n)
+{
+	noDataTimeout = 1000;			// If next frame isn't within 1s, then turn off the Grn LED in Timer.
+	if(memcmp(slots, dmxData, n))
+	{
+		grnTimeout = 250;			// Blink green on a change
+		LATBbits.LATB4 = 0;
+	}
+	else if(grnTimeout <= 0)		// Solid LED, coz we have valid dmx data (set LED only when grnTimeout is zero)
+		LATBbits.LATB4 = 1;
+	memcpy(dmxData, slots, n);		// Save the data
+	fixture_frame(slots, n);		// Every output from this one frame
+}
+
+
+//*******************************************//
+// Answer a POLL if it asks for this Device  //
+//*******************************************//
+void pollAnswer(int pollData)
+{
+	if(pollData && dmxrx_ok())		// Only a probe received in one piece
+	{
+		dmxrx_end();
+		dmxWrOn = 1; 				// DMX Write On
+		wait_us(1);					// Give time to properly convert from read to write mode
+		brkFunc();					// Send Break and address, then release the bus
+		redTimeout = 250;			// Set RED LED, indicate break is sent
+		LATBbits.LATB5 = 1;
+	}
+}
+
+
+void pollAll()
+{
+	pollAnswer(retriveData());		// 0xF0: a slot per address
+}
+
+
+void pollWindow()
+{
+	pollAnswer(retriveWindow());	// 0xF1: address window and mask
+}
+
+
+//-----------------------------------------------------------------------------
+// Start codes the Device knows. A new protocol only needs a line here.
+// Others are counted in 'otherFrames' and skipped like DMXRX_SKIP.
+//-----------------------------------------------------------------------------
+START_CODE startCodes[] = {
+	{0x00,		DMXRX_MINE,	0,			dmxFrame,	0},	// DMX data
+	{0xF0,		DMXRX_ALL,	pollAll,	0,			0},	// POLL, all 512 slots
+	{0xF1,		DMXRX_ALL,	pollWindow,	0,			0},	// POLL of an address window
+	{RDM_SC,	DMXRX_ALL,	rdmAnswer,	0,			0},	// RDM
+	{0x17,		DMXRX_SKIP,	0,			0,			0},	// ASCII text, nothing to show it on
+	{0xCF,		DMXRX_SKIP,	0,			0,			0},	// System Information Packet, counted only
+};
+
+
+//*************************************************//
+// Table entry of a start code, 0 if there is none //
+//*************************************************//
+START_CODE *findStartCode(unsigned char code)
+{
+	unsigned int i;
+
+	for(i=0;i<sizeof(startCodes)/sizeof(startCodes[0]);i++)
+	{
+		if(startCodes[i].code == code)
+			return &startCodes[i];
+	}
+	return 0;
+}
+
+
+//*****************************************************//
+// Start code came (receive interrupt): what is it for //
+//*****************************************************//
+int startPacket(unsigned char code)
+{
+	rxCode = findStartCode(code);
+	if(!rxCode)
+	{
+		otherFrames++;
+		return DMXRX_SKIP;
+	}
+	rxCode->frames++;
+	return rxCode->slots;
+}
+
+
+//************************************************//
+// DMXRX_MINE window complete (receive interrupt) //
+//************************************************//
+void framePacket(const unsigned char slots[], unsigned int n)
+{
+	if(rxCode && rxCode->frame)
+		rxCode->frame(slots, n);
+}
+
+
+//*****************************************//
+// DMXRX_ALL packet: its handler reads it  //
+//*****************************************//
+void readPacket(unsigned char code)
+{
+	START_CODE *sc = findStartCode(code);
+
+	if(sc && sc->start)
+		sc->start();
+	dmxrx_end();					// Drop whatever the handler didn't want
+}
+
+
+//*******************************************************//
+// Address from the DIP switches, unless RDM patched it  //
+//*******************************************************//
+void updateAddr()
+{
+	readDevAdd();
+	if(rdmDev.addrSet)				// Patched by RDM, DIP switches count again after power down
+		devAdd = rdmDev.address;
+	else
+		rdmDev.address = devAdd;
+	if(devAdd+fixture_footprint() > 513)	// Footprint runs off the end, the outputs past 512 stay off
+		dmxrx_window(devAdd, 513-devAdd);
+	else
+		dmxrx_window(devAdd, fixture_footprint());
+}
+
 
 //----------------------------------------------------------------------------
 // MAIN starts here
@@ -242,19 +506,15 @@ int retriveData()
 
 int main()
 { 
-   // Variable Declarations
-   unsigned char temp;
-   unsigned char dmxData;			// DMX Data
-   unsigned char pollData;			// Poll data
-   unsigned int dmxRdIndex;			// Keep track of dmxData
-   int brkFlag = 0;					// Indication of Break
-
-
    // Initializations...
    init_hw();                 		// Initialize hardware
-   pwm_init();	
+   pwm_init();						// OC1-OC4 off Timer2
+   fixture_select(DEV_PERSONALITY);
    uart2_init(BAUD_250K);			// Configure uart2
    timer1_init(625);				// (40M/64)*1m = 625
+   dmxbrk_init();					// Timer3 for Break and MAB
+   readDevAdd();
+   rdmresp_init(&rdmDev, devUid, devAdd, fixture_footprint());	// Footprint from the DIP switch address
    
    dmxWrOn = 0; 					// DMX Read On
 
@@ -262,66 +522,35 @@ int main()
    wait_ms(500);
    LATBbits.LATB4 = 0;
 
+   dmxrx_init(startPacket, framePacket);	// Bytes come by interrupt from here on
+   updateAddr();
+
 
    while(1)
    {
-		readDevAdd();							// Read Device Address
+		int code;
 
-		if(U2STAbits.URXDA)						// Is there any data in USART2
+		if(addrChanged)							// DIP switches moved
 		{
-			if(U2STAbits.FERR)					// Is it with frame error?
-			{	
-				if(uart2_getc() == 0)			// Is it Break?
-				{
-					temp = uart2_getc();
-					if(temp == 0)				// Is start code is zero?
-					{
-						brkFlag = 1;			// Got the Break, set the flag.
-						dmxRdIndex = 1;			// Initialize the Index
-						noDataTimeout = 1000;	// If next break isn't within 1s, then turn off the Grn LED in Timer.
-						if(grnTimeout <= 0)		// Solid LED, coz we have valid dmx data (set LED only when grnTimeout is zero)
-							LATBbits.LATB4 = 1;
-					}
-					else if(temp == 0xF0)		// Is it POLL code?
-					{
-						pollData = retriveData();
-						
-						if(pollData)
-						{
-							dmxWrOn = 1; 				// DMX Write On
-							wait_us(1);					// Give time to properly convert from read to write mode
-							brkFunc();					// Send Break
-							redTimeout = 250;			// Set RED LED, indicate break is sent
-							LATBbits.LATB5 = 1;
-							dmxWrOn = 0; 				// DMX Read On
-						}
-					}
-				}
-			}
-			else if(brkFlag)					// Do we have a valid Break?
-			{	
-				temp = uart2_getc();			// Read the data
-				if(dmxRdIndex == devAdd)		// Is the data for the device?
-				{	
-					if(temp != dmxData)
-					{
-						grnTimeout = 250;
-						LATBbits.LATB4 = 0;
-					}
-					dmxData = temp;				// Save the data
-					pwm_setdc(temp);
-					brkFlag = 0;				// Reset the Break flag i.e. again wait for break
-					dmxRdIndex = 0;				// Reset the DMX data index. Not Necessary!
-				}
-
-				if (++dmxRdIndex>=513) 			// Avoid overflow of the index
-					dmxRdIndex = 0;
-			}
-			else
-			{	
-				uart2_getc();					// To avoid overrun keep reading the data.
-			}
+			addrChanged = 0;
+			updateAddr();
 		}
+		if(rdmDev.identify)						// RDM IDENTIFY_DEVICE: red LED stays on
+		{
+			redTimeout = 250;
+			LATBbits.LATB5 = 1;
+		}
+
+		code = dmxrx_packet();
+		if(code >= 0)							// POLL or RDM, read and answered here
+		{
+			readPacket(code);
+			if(code == RDM_SC)
+				updateAddr();					// DMX_START_ADDRESS may have changed it
+			continue;
+		}
+
+		Idle();									// Nothing to do up to the next interrupt
    }
    
    return 0;
@@ -0,0 +1,212 @@
+/*! \file pwm.c \brief PWM outputs of the Device. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'pwm.c'
+// Title		: PWM outputs
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.1
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    Timer2, OC1 to OC4
+
+// OC1 to OC4 run in PWM mode off Timer2 at Fcy with PR2 = 4095: 12 bit at
+// 9.77 kHz (16 bit straight from the hardware would be down at 610 Hz).
+// The low 4 bits of a 16 bit level are dithered: over 16 periods the duty
+// cycle is one count longer as often as they say.
+//
+// pwm_set() takes a 16 bit level (0 off, 0xFFFF full on) and puts it
+// through the dimmer curve. pwm_frame() says all outputs of a frame are
+// set; from then on every output fades from where it is to its new level,
+// one step per PWM period, over the time the last frame took (at most
+// PWM_FADE_MAX). So 44 frames per second come out as 9770 small steps.
+// All four OCxRS are written in the same Timer2 interrupt, and the OC
+// modules only take them at the next period: the outputs never show parts
+// of two frames.
+//
+// The curve is a table of 257 points built by the preprocessor (CURVE()
+// on every point), levels in between are interpolated.
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include <p33FJ128MC802.h>
+#include "pwm.h"
+
+
+#define FRAC 14						// Fraction bits of a fading level
+#define DITHER (16 - PWM_BITS)		// Bits of a level below the duty cycle
+#define DITHER_MASK ((1 << DITHER) - 1)
+
+// Dimmer curve of point x (0 to 256), 0 to 0xFFFF
+#if PWM_CURVE == PWM_GAMMA
+ #define CURVE(x) ((unsigned int)(((4ULL*256*(x)*(x) + 1ULL*(x)*(x)*(x)) * 0xFFFF) / (5ULL*256*256*256)))
+#else
+ #define CURVE(x) ((unsigned int)((x)*0xFFFFUL/256))
+#endif
+
+#define P4(x)	CURVE(x), CURVE((x)+1), CURVE((x)+2), CURVE((x)+3)
+#define P16(x)	P4(x), P4((x)+4), P4((x)+8), P4((x)+12)
+#define P64(x)	P16(x), P16((x)+16), P16((x)+32), P16((x)+48)
+
+const unsigned int curve[257] = {P64(0), P64(64), P64(128), P64(192), CURVE(256)};
+
+
+// One output
+typedef struct
+{
+	volatile unsigned int *rs;		// Duty cycle register
+	unsigned int next;				// Level for the next pwm_frame()
+	unsigned long level;			// Now, with FRAC fraction bits
+	long step;						// Added every period while fading
+	unsigned int left;				// Periods of the fade left
+	unsigned int dither;			// Dither sum
+} PWM_OUT;
+
+PWM_OUT outs[PWM_OUTPUTS] = {{&OC1RS}, {&OC2RS}, {&OC3RS}, {&OC4RS}};
+volatile unsigned int periods;		// PWM periods since the last pwm_frame()
+
+
+//-----------------------------------------------------------------------------
+// Interrupt Subroutines
+//-----------------------------------------------------------------------------
+
+// For TIMER2 (every PWM period): fade and dither
+void __attribute__((interrupt, no_auto_psv)) _T2Interrupt(void)
+{
+	PWM_OUT *o;
+	unsigned int i, v, duty;
+
+	for(i=0;i<PWM_OUTPUTS;i++)
+	{
+		o = &outs[i];
+		if(o->left)
+		{
+			o->left--;
+			if(o->left)
+				o->level += o->step;
+			else
+				o->level = (unsigned long)o->next << FRAC;	// No rounding left over at the end
+		}
+		v = o->level >> FRAC;
+		duty = v >> DITHER;
+		o->dither += v & DITHER_MASK;
+		if(o->dither > DITHER_MASK)	// One count more this period
+		{
+			o->dither -= DITHER_MASK+1;
+			duty++;
+		}
+		if(v == 0xFFFF)
+			duty = PR2+1;			// On all the time
+		*o->rs = duty;
+	}
+	if(periods < 0xFFFF)
+		periods++;
+
+	IFS0bits.T2IF = 0;				// Clear the flag
+}
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void pwm_init(void)
+{
+  unsigned int i;
+
+  // Clock timer 2 with internal 40 MHz clock
+  // and set period to 102.4us
+  T2CON = 0;
+  TMR2 = 0;
+  T2CONbits.TCS = 0;	// Select Fcy
+  T2CONbits.TCKPS = 0;	// Prescaler 1
+  PR2 = (1 << PWM_BITS) - 1;
+
+  OC1CON = 0;			// turn-off OCx to make sure changes can be applied
+  OC2CON = 0;
+  OC3CON = 0;
+  OC4CON = 0;
+  OC1R = OC2R = OC3R = OC4R = 0;		// set first cycle d.c.
+  OC1RS = OC2RS = OC3RS = OC4RS = 0;	// set ongoing d.c. to 0
+  OC1CONbits.OCTSEL = 0;// Select Timer 2 as source
+  OC2CONbits.OCTSEL = 0;
+  OC3CONbits.OCTSEL = 0;
+  OC4CONbits.OCTSEL = 0;
+  OC1CONbits.OCM = 6;	// Set OCx to PWM mode
+  OC2CONbits.OCM = 6;
+  OC3CONbits.OCM = 6;
+  OC4CONbits.OCM = 6;
+
+  for(i=0;i<PWM_OUTPUTS;i++)
+  {
+	outs[i].next = 0;
+	outs[i].level = 0;
+	outs[i].left = 0;
+	outs[i].dither = 0;
+  }
+  periods = 0;
+
+  IFS0bits.T2IF = 0;	// Clear the flag
+  IEC0bits.T2IE = 1;	// Enable timer 2 interrupts
+  T2CONbits.TON = 1;
+}
+
+
+// Level of an output for the next pwm_frame(), 0 to 0xFFFF
+void pwm_set(unsigned int out, unsigned int level)
+{
+	unsigned int lo, hi, frac;
+
+	if(out >= PWM_OUTPUTS)
+		return;
+	lo = curve[level >> 8];
+	hi = curve[(level >> 8) + 1];
+	frac = (level & 0xFF) + (level >> 15);	// 0 to 256, so 0xFFFF gets to the last point
+	outs[out].next = lo + (((unsigned long)(hi - lo) * frac) >> 8);
+}
+
+
+// Start fading every output to its pwm_set() level, over the last frame time
+void pwm_frame(void)
+{
+	PWM_OUT *o;
+	unsigned int i, n;
+
+	IEC0bits.T2IE = 0;				// All outputs start in the same period
+	n = periods;
+	periods = 0;
+	if(n > PWM_FADE_MAX)			// First frame after a pause
+		n = PWM_FADE_MAX;
+	if(n < 1)
+		n = 1;
+	for(i=0;i<PWM_OUTPUTS;i++)
+	{
+		o = &outs[i];
+		o->step = (((long)o->next << FRAC) - (long)o->level) / (long)n;
+		o->left = n;
+	}
+	IEC0bits.T2IE = 1;
+}
+
+
+// Level (after the curve) an output is at now
+unsigned int pwm_get(unsigned int out)
+{
+	unsigned long level;
+
+	if(out >= PWM_OUTPUTS)
+		return 0;
+	IEC0bits.T2IE = 0;
+	level = outs[out].level;
+	IEC0bits.T2IE = 1;
+	return level >> FRAC;
+}
@@ -0,0 +1,35 @@
+/*! \file pwm.h \brief PWM outputs of the Device. */
+//*****************************************************************************
+//
+// File Name	: 'pwm.h'
+// Title		: PWM outputs
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.1
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __PWM_H__
+ #define __PWM_H__
+
+
+#define PWM_OUTPUTS 4				// OC1 to OC4
+#define PWM_BITS 12					// Hardware duty cycle resolution, 4 more by dithering
+#define PWM_HZ (40000000UL >> PWM_BITS)	// 9.77 kHz
+#define PWM_FADE_MAX (PWM_HZ/20)	// Longest fade between two frames (50 ms)
+
+#define PWM_LINEAR 0				// Dimmer curves
+#define PWM_GAMMA 1					// About gamma 2.2 (4/5 x^2 + 1/5 x^3)
+#ifndef PWM_CURVE
+ #define PWM_CURVE PWM_GAMMA
+#endif
+
+
+//Functions
+void pwm_init(void);
+void pwm_set(unsigned int out, unsigned int level);
+void pwm_frame(void);
+unsigned int pwm_get(unsigned int out);
+
+#endif
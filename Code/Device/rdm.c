@@ -0,0 +1,203 @@
+/*! \file rdm.c \brief RDM (ANSI E1.20) packets. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'rdm.c'
+// Title		: RDM packets
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    None
+
+// Packet framing for both ends of the bus; the Controller and the Device
+// have the same copy of this file. A packet is kept as it goes on the wire:
+// start code 0xCC first, the 16 bit checksum (sum of every byte before it)
+// last. A UID is 6 bytes, manufacturer first, so memcmp() orders UIDs like
+// numbers.
+//
+// The answer to DISC_UNIQUE_BRANCH has no Break and no packet around it: a
+// preamble of 0xFE, 0xAA, then the UID and its checksum with every byte
+// sent twice (OR 0xAA, then OR 0x55). Several Devices answering at once
+// spoil the checksum, which tells the Controller to split the branch.
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include <string.h>
+#include "rdm.h"
+
+
+#define DUB_PREAMBLE 7
+#define DUB_SEPARATOR 0xAA
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+static unsigned int rdm_sum(const unsigned char buf[], unsigned int n)
+{
+	unsigned int sum = 0;
+
+	while(n--)
+		sum += *buf++;
+	return sum;
+}
+
+
+// Whole packet into 'pkt'. Returns its length, checksum included.
+unsigned int rdm_build(unsigned char pkt[], const unsigned char dest[], const unsigned char src[],
+		unsigned char tn, unsigned char port, unsigned char cc, unsigned int pid,
+		const unsigned char pd[], unsigned char pdl)
+{
+	unsigned int n = RDM_PD + pdl, sum;
+
+	if(pdl > RDM_PD_MAX)
+		return 0;
+	pkt[0] = RDM_SC;
+	pkt[1] = RDM_SUB_SC;
+	pkt[RDM_LEN] = n;
+	memcpy(pkt+RDM_DEST, dest, RDM_UID_LEN);
+	memcpy(pkt+RDM_SRC, src, RDM_UID_LEN);
+	pkt[RDM_TN] = tn;
+	pkt[RDM_PORT] = port;
+	pkt[RDM_MSGS] = 0;
+	pkt[RDM_SUBDEV] = 0;			// Root device only
+	pkt[RDM_SUBDEV+1] = 0;
+	pkt[RDM_CC] = cc;
+	pkt[RDM_PID] = pid >> 8;
+	pkt[RDM_PID+1] = pid & 0xFF;
+	pkt[RDM_PDL] = pdl;
+	if(pdl)
+		memcpy(pkt+RDM_PD, pd, pdl);
+	sum = rdm_sum(pkt, n);
+	pkt[n] = sum >> 8;
+	pkt[n+1] = sum & 0xFF;
+	return n+2;
+}
+
+
+// Is 'pkt' a whole packet with the right checksum?
+int rdm_check(const unsigned char pkt[], unsigned int n)
+{
+	unsigned int len;
+
+	if(n < RDM_PD+2 || pkt[0] != RDM_SC || pkt[1] != RDM_SUB_SC)
+		return 0;
+	len = pkt[RDM_LEN];
+	if(len < RDM_PD || len+2 > n || pkt[RDM_PDL] != len-RDM_PD)
+		return 0;
+	return rdm_sum(pkt, len) == ((pkt[len] << 8) | pkt[len+1]);
+}
+
+
+// Has 'buf' got all of a packet, or all of a DISC_UNIQUE_BRANCH answer?
+int rdm_complete(const unsigned char buf[], unsigned int n)
+{
+	unsigned int i;
+
+	if(n && buf[0] == RDM_SC)
+		return n >= 3 && n >= buf[RDM_LEN]+2u;
+	for(i=0;i<n && i<DUB_PREAMBLE && buf[i] == 0xFE;i++);
+	return i < n && buf[i] == DUB_SEPARATOR && n >= i+1+16;
+}
+
+
+unsigned int rdm_pid(const unsigned char pkt[])
+{
+	return (pkt[RDM_PID] << 8) | pkt[RDM_PID+1];
+}
+
+
+// Answer to DISC_UNIQUE_BRANCH. Returns its length, RDM_DUB_LEN.
+unsigned int rdm_dubBuild(unsigned char out[], const unsigned char uid[])
+{
+	unsigned int i, n = 0, sum;
+
+	for(i=0;i<DUB_PREAMBLE;i++)
+		out[n++] = 0xFE;
+	out[n++] = DUB_SEPARATOR;
+	for(i=0;i<RDM_UID_LEN;i++)
+	{
+		out[n++] = uid[i] | 0xAA;
+		out[n++] = uid[i] | 0x55;
+	}
+	sum = rdm_sum(out+DUB_PREAMBLE+1, 2*RDM_UID_LEN);
+	out[n++] = (sum >> 8) | 0xAA;
+	out[n++] = (sum >> 8) | 0x55;
+	out[n++] = (sum & 0xFF) | 0xAA;
+	out[n++] = (sum & 0xFF) | 0x55;
+	return n;
+}
+
+
+// UID in an answer to DISC_UNIQUE_BRANCH. 0 if it is spoilt (collision).
+int rdm_dubDecode(const unsigned char in[], unsigned int n, unsigned char uid[])
+{
+	unsigned int i, sum, check;
+
+	for(i=0;i<n && i<DUB_PREAMBLE && in[i] == 0xFE;i++);	// Preamble may be cut short
+	if(i >= n || in[i] != DUB_SEPARATOR || n < i+1+16)
+		return 0;
+	in += i+1;
+	for(i=0;i<16;i+=2)
+	{
+		if((in[i] & 0xAA) != 0xAA || (in[i+1] & 0x55) != 0x55)
+			return 0;				// Not sent that way
+	}
+	sum = rdm_sum(in, 2*RDM_UID_LEN);
+	check = ((in[12] & in[13]) << 8) | (in[14] & in[15]);
+	if(sum != check)
+		return 0;
+	for(i=0;i<RDM_UID_LEN;i++)
+		uid[i] = in[2*i] & in[2*i+1];
+	return 1;
+}
+
+
+// Is 'dest' this UID, or a broadcast which takes it in?
+int rdm_forUid(const unsigned char dest[], const unsigned char uid[])
+{
+	if(!memcmp(dest+2, "\xFF\xFF\xFF\xFF", 4))	// All Devices of a manufacturer
+		return (dest[0] == 0xFF && dest[1] == 0xFF) || (dest[0] == uid[0] && dest[1] == uid[1]);
+	return !memcmp(dest, uid, RDM_UID_LEN);
+}
+
+
+// Nobody answers a broadcast
+int rdm_broadcast(const unsigned char dest[])
+{
+	return !memcmp(dest+2, "\xFF\xFF\xFF\xFF", 4);
+}
+
+
+unsigned long long rdm_uidNum(const unsigned char uid[])
+{
+	unsigned long long num = 0;
+	int i;
+
+	for(i=0;i<RDM_UID_LEN;i++)
+		num = (num << 8) | uid[i];
+	return num;
+}
+
+
+void rdm_uidSet(unsigned char uid[], unsigned long long num)
+{
+	int i;
+
+	for(i=RDM_UID_LEN-1;i>=0;i--)
+	{
+		uid[i] = num & 0xFF;
+		num >>= 8;
+	}
+}
@@ -0,0 +1,201 @@
+/*! \file rdmresp.c \brief RDM responder. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'rdmresp.c'
+// Title		: RDM responder
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+
+// Target uC:       33FJ128MC802
+// Clock Source:    8 MHz primary oscillator set in configuration bits
+// Clock Rate:      80 MHz using prediv=2, plldiv=40, postdiv=2
+// Devices used:    None
+
+// Answers an RDM request. rdmresp_handle() takes the packet as received
+// (start code 0xCC first, checksum last) and makes the answer; sending it is
+// up to the caller. All state is in an RDM_RESP, so one firmware could
+// answer for several responders (and the host test runs many of them).
+//
+// Supported: DISC_UNIQUE_BRANCH, DISC_MUTE, DISC_UN_MUTE, GET DEVICE_INFO,
+// GET/SET DMX_START_ADDRESS and GET/SET IDENTIFY_DEVICE. Anything else
+// addressed to us gets NACK_REASON UNKNOWN_PID. Broadcasts are carried out
+// and never answered; spoilt packets are dropped.
+//*****************************************************************************
+
+
+
+//-----------------------------------------------------------------------------
+// Device includes and assembler directives
+//-----------------------------------------------------------------------------
+#include <string.h>
+#include "rdmresp.h"
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void rdmresp_init(RDM_RESP *r, const unsigned char uid[], unsigned int address, unsigned int footprint)
+{
+	memcpy(r->uid, uid, RDM_UID_LEN);
+	r->address = address;
+	r->footprint = footprint;
+	r->muted = 0;
+	r->identify = 0;
+	r->addrSet = 0;
+}
+
+
+// Answer with 'pdl' bytes of data, or a NACK if 'nack' isn't 0xFFFF
+static unsigned int rdmresp_answer(RDM_RESP *r, const unsigned char req[], unsigned char resp[],
+		const unsigned char pd[], unsigned char pdl, unsigned int nack)
+{
+	unsigned char reason[2];
+
+	if(nack != 0xFFFF)
+	{
+		reason[0] = nack >> 8;
+		reason[1] = nack & 0xFF;
+		return rdm_build(resp, req+RDM_SRC, r->uid, req[RDM_TN], RDM_NACK, req[RDM_CC]+1,
+				rdm_pid(req), reason, 2);
+	}
+	return rdm_build(resp, req+RDM_SRC, r->uid, req[RDM_TN], RDM_ACK, req[RDM_CC]+1,
+			rdm_pid(req), pd, pdl);
+}
+
+
+// DISC_UNIQUE_BRANCH, DISC_MUTE and DISC_UN_MUTE
+static unsigned int rdmresp_disc(RDM_RESP *r, const unsigned char req[], unsigned char resp[], int *brk)
+{
+	unsigned char control[2] = {0, 0};	// No managed proxy, no sub-devices
+	unsigned long long me;
+
+	switch(rdm_pid(req))
+	{
+		case RDM_PID_DUB:
+			if(r->muted || req[RDM_PDL] != 2*RDM_UID_LEN)
+				return 0;
+			me = rdm_uidNum(r->uid);
+			if(me < rdm_uidNum(req+RDM_PD) || me > rdm_uidNum(req+RDM_PD+RDM_UID_LEN))
+				return 0;
+			*brk = 0;				// Only this answer goes without a Break
+			return rdm_dubBuild(resp, r->uid);
+
+		case RDM_PID_MUTE:
+			r->muted = 1;
+			break;
+
+		case RDM_PID_UNMUTE:
+			r->muted = 0;
+			break;
+
+		default:
+			return 0;
+	}
+	if(rdm_broadcast(req+RDM_DEST))
+		return 0;
+	return rdmresp_answer(r, req, resp, control, sizeof(control), 0xFFFF);
+}
+
+
+// Answer to a request, 0 if there is none. '*brk' tells if a Break goes first.
+unsigned int rdmresp_handle(RDM_RESP *r, const unsigned char req[], unsigned int len,
+		unsigned char resp[], int *brk)
+{
+	unsigned char pd[RDM_DEVINFO_LEN];
+	unsigned int pid, addr, nack = 0xFFFF;
+	unsigned char pdl = 0;
+	int get;
+
+	*brk = 1;
+	if(!rdm_check(req, len) || !rdm_forUid(req+RDM_DEST, r->uid))
+		return 0;
+	if(req[RDM_CC] == RDM_DISC)
+		return rdmresp_disc(r, req, resp, brk);
+
+	get = (req[RDM_CC] == RDM_GET);
+	pid = rdm_pid(req);
+	if(!get && req[RDM_CC] != RDM_SET)
+		nack = RDM_NR_CC;
+	else if(req[RDM_SUBDEV] || req[RDM_SUBDEV+1])
+		nack = RDM_NR_SUB_DEVICE;	// No sub-devices
+	else if(get && req[RDM_PDL])
+		nack = RDM_NR_FORMAT;
+	else switch(pid)
+	{
+		case RDM_PID_DEVINFO:
+			if(!get)
+			{
+				nack = RDM_NR_CC;
+				break;
+			}
+			pd[0] = 0x01;			// RDM protocol 1.0
+			pd[1] = 0x00;
+			pd[2] = RDMRESP_MODEL >> 8;
+			pd[3] = RDMRESP_MODEL & 0xFF;
+			pd[4] = RDMRESP_CATEGORY >> 8;
+			pd[5] = RDMRESP_CATEGORY & 0xFF;
+			pd[6] = RDMRESP_VERSION >> 24;
+			pd[7] = (RDMRESP_VERSION >> 16) & 0xFF;
+			pd[8] = (RDMRESP_VERSION >> 8) & 0xFF;
+			pd[9] = RDMRESP_VERSION & 0xFF;
+			pd[10] = r->footprint >> 8;
+			pd[11] = r->footprint & 0xFF;
+			pd[12] = 1;				// Personality 1 of 1
+			pd[13] = 1;
+			pd[14] = r->address >> 8;
+			pd[15] = r->address & 0xFF;
+			pd[16] = 0;				// No sub-devices
+			pd[17] = 0;
+			pd[18] = 0;				// No sensors
+			pdl = RDM_DEVINFO_LEN;
+			break;
+
+		case RDM_PID_ADDR:
+			if(get)
+			{
+				pd[0] = r->address >> 8;
+				pd[1] = r->address & 0xFF;
+				pdl = 2;
+			}
+			else if(req[RDM_PDL] != 2)
+				nack = RDM_NR_FORMAT;
+			else
+			{
+				addr = (req[RDM_PD] << 8) | req[RDM_PD+1];
+				if(addr < 1 || addr+r->footprint > 513)
+					nack = RDM_NR_RANGE;
+				else
+				{
+					r->address = addr;
+					r->addrSet = 1;	// DIP switches don't count any more
+				}
+			}
+			break;
+
+		case RDM_PID_IDENTIFY:
+			if(get)
+			{
+				pd[0] = r->identify;
+				pdl = 1;
+			}
+			else if(req[RDM_PDL] != 1)
+				nack = RDM_NR_FORMAT;
+			else if(req[RDM_PD] > 1)
+				nack = RDM_NR_RANGE;
+			else
+				r->identify = req[RDM_PD];
+			break;
+
+		default:
+			nack = RDM_NR_UNKNOWN_PID;
+	}
+
+	if(rdm_broadcast(req+RDM_DEST))
+		return 0;
+	return rdmresp_answer(r, req, resp, pd, pdl, nack);
+}
@@ -0,0 +1,41 @@
+/*! \file rdmresp.h \brief RDM responder. */
+//*****************************************************************************
+//
+// File Name	: 'rdmresp.h'
+// Title		: RDM responder
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __RDMRESP_H__
+ #define __RDMRESP_H__
+
+#include "rdm.h"
+
+
+#define RDMRESP_MODEL 0x0001		// Device model ID
+#define RDMRESP_CATEGORY 0x0101		// PRODUCT_CATEGORY_FIXTURE_FIXED
+#define RDMRESP_VERSION 0x00010000UL	// Software version ID, 1.0
+
+
+// State of one responder
+typedef struct
+{
+	unsigned char uid[RDM_UID_LEN];
+	unsigned int address;			// DMX start address
+	unsigned int footprint;			// Slots used from 'address' on
+	unsigned char muted;			// Stays out of discovery
+	unsigned char identify;			// IDENTIFY_DEVICE is on
+	unsigned char addrSet;			// 'address' came by RDM, not from the DIP switches
+} RDM_RESP;
+
+
+//Functions
+void rdmresp_init(RDM_RESP *r, const unsigned char uid[], unsigned int address, unsigned int footprint);
+unsigned int rdmresp_handle(RDM_RESP *r, const unsigned char req[], unsigned int len,
+		unsigned char resp[], int *brk);
+
+#endif
@@ -0,0 +1,51 @@
+/*! \file ring.h \brief Single producer, single consumer byte queue. */
+//*****************************************************************************
+//
+// File Name	: 'ring.h'
+// Title		: Ring buffer
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target uC	: 33FJ128MC802
+//*****************************************************************************
+
+#ifndef __RING_H__
+ #define __RING_H__
+
+
+// ring_write() modes
+#define RING_NOBLOCK 0				// Write what fits, count the rest as dropped
+#define RING_BLOCK 1				// Wait for room (never from an interrupt)
+#define RING_TRY 2					// All or nothing, nothing counted
+
+
+typedef struct
+{
+	volatile unsigned char *buf;
+	unsigned int mask;				// Size - 1, size is a power of 2
+	volatile unsigned int head;		// End of the published bytes (producer)
+	volatile unsigned int tail;		// Next byte to read (consumer)
+	unsigned int put;				// Producer's position, ahead of 'head' while pending
+	void (*kick)(void);				// Tells the consumer there is data (or 0)
+	unsigned int highWater;			// Most bytes ever queued
+	unsigned int drops;				// Bytes that didn't fit
+} RING;
+
+
+//Functions
+void ring_init(RING *r, unsigned char *buf, unsigned int size, void (*kick)(void));
+unsigned int ring_write(RING *r, const unsigned char *data, unsigned int len, int mode);
+int ring_put(RING *r, unsigned char data, int mode);
+int ring_get(RING *r);
+unsigned int ring_count(RING *r);
+unsigned int ring_free(RING *r);
+
+int ring_pend(RING *r, unsigned char data);
+void ring_unpend(RING *r);
+unsigned int ring_pending(RING *r);
+void ring_poke(RING *r, unsigned int offset, unsigned char data);
+void ring_publish(RING *r);
+void ring_discard(RING *r);
+
+#endif
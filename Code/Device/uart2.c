@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "uart2.h"
+#include "hal.h"
 
 //-----------------------------------------------------------------------------
 // Subroutines                
@@ -56,7 +57,8 @@ void uart2_puts(const char str[])
 void uart2_putc(char data)
 {
    // make sure buffer is empty
-   while(U2STAbits.UTXBF);
+   while(U2STAbits.UTXBF)
+     hal_spin();
    // write character
    U2TXREG = data;
 }
@@ -68,7 +70,8 @@ unsigned char uart2_getc()
   
   
   // wait until character is ready
-  while(!U2STAbits.URXDA);
+  while(!U2STAbits.URXDA)
+    hal_spin();
   data = U2RXREG;
 
   // clear out any overflow error condition
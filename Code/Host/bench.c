@@ -0,0 +1,427 @@
+/*! \file bench.c \brief Performance numbers of the Controller on the host. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'bench.c'
+// Title		: Controller benchmarks
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// Runs 'controller.so' and 'device.so' on the bus of 'bus.c' and prints one
+// CSV line per result: metric,param,value,unit
+// - fps:          frames per second for 'max' (maxDmxAddr) = param, 0 = auto
+// - set_us_*:     end of a 'set' line on UART1 to the slot on the wire
+// - clear_us_*:   the same for 'clear'; min, avg and max of LAT_RUNS runs,
+//                 each started at another point of the frame. Param: slot.
+// - poll_found:   Devices a 'poll' search (disc_*) listed, param: Devices/spread
+// - poll_probes:  probes it took
+// - poll_bus_s:   bus time of its probes, as the Controller reports it
+// - poll_done_s:  end of 'poll' to the result on UART1, DMX frames in between
+// - poll_host_s:  what that took the host
+// - parse_ns:     processCmd() per line, param: the kind of line
+// The bus runs on model time and the Devices sit at addresses from a fixed
+// seed, so everything but the units ending in '_wall' comes out the same on
+// every run and every machine. 'bench old.csv' compares with an earlier run
+// and exits non zero if one of those got worse.
+// 'bench N' (or 'bench N old.csv') searches up to N Devices, DEVICES if not
+// given.
+//*****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+#include "bus.h"
+#include "ring.h"
+
+
+#define DEVICES 32					// Largest search, unless the command line says
+#define LAT_RUNS 8
+#define FRAME_US 23000				// Longest frame: offsets of the latency runs
+#define PARSE_RUNS 200000
+#define RESULTS 128
+
+
+typedef struct
+{
+	char metric[24];
+	char param[24];
+	double value;
+	char unit[12];
+} RESULT;
+
+RESULT result[RESULTS];
+unsigned int results;
+BUS_NODE *ctl;
+unsigned long seed;
+int worse = 0;
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Same sequence on every run
+static unsigned int lcg(void)
+{
+	seed = seed*1103515245UL + 12345;
+	return (seed >> 16) & 0x7FFF;
+}
+
+
+static double wall(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec/1e9;
+}
+
+
+static void report(const char *metric, const char *param, double value, const char *unit)
+{
+	RESULT *r = &result[results];
+
+	printf("%s,%s,%.3f,%s\n", metric, param, value, unit);
+	if(results == RESULTS)
+		return;
+	snprintf(r->metric, sizeof(r->metric), "%s", metric);
+	snprintf(r->param, sizeof(r->param), "%s", param);
+	snprintf(r->unit, sizeof(r->unit), "%s", unit);
+	r->value = value;
+	results++;
+}
+
+
+// Type a line and let it in, up to its last character
+static unsigned long typed(const char *line)
+{
+	bus_type(ctl, line);
+	while(ctl->pcPending())
+		bus_run(1);
+	return bus_now();
+}
+
+
+// Controller alone on the bus, after its 500 ms LED blink
+static void ctlOnly(void)
+{
+	bus_close();
+	ctl = bus_load("./controller.so", "controller_main");
+	bus_run(600000);
+}
+
+
+//-----------------------------------------------------------------------------
+// Frame rate
+//-----------------------------------------------------------------------------
+
+static void fps(void)
+{
+	static const unsigned int max[] = {0, 24, 64, 128, 256, 512};
+	unsigned long frames;
+	unsigned int i;
+	char line[16];
+
+	ctlOnly();
+	typed("set 100 1");				// 'max 0' ends the frame here
+	bus_run(100000);
+	for(i=0;i<sizeof(max)/sizeof(max[0]);i++)
+	{
+		sprintf(line, "max %u", max[i]);
+		typed(line);
+		bus_run(100000);			// New length from the next frame on
+		frames = bus_breaks();
+		bus_run(1000000);
+		sprintf(line, "%u", max[i]);
+		report("fps", line, bus_breaks() - frames, "1/s");
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Command to wire
+//-----------------------------------------------------------------------------
+
+// us from 'start' to the first frame with 'value' in slot 'addr', 0 if none comes
+static unsigned long onWire(unsigned long start, unsigned int addr, unsigned int value)
+{
+	const SIM_WIRE *(*wire)(void) = bus_sym(ctl, "sim_wire");
+	const SIM_WIRE *w;
+	unsigned int i, n, seen = 0;
+	int slot = -1;
+
+	while(bus_now() - start < 4*FRAME_US)
+	{
+		bus_run(100);
+		w = wire();
+		n = ctl->wireCount();
+		for(i=seen;i<n;i++)
+		{
+			if(w[i].data == SIM_BREAK)
+				slot = 0;
+			else if(slot >= 0 && slot++ == addr && w[i].data == value)
+				return w[i].us - start;
+		}
+		seen = n;
+	}
+	return 0;
+}
+
+
+static void latency(const char *cmd)
+{
+	static const unsigned int addr[] = {1, 256, 512};
+	unsigned long us, min, max, sum;
+	unsigned int i, k;
+	char line[24], metric[24];
+
+	ctlOnly();
+	seed = 1;
+	for(i=0;i<sizeof(addr)/sizeof(addr[0]);i++)
+	{
+		min = ~0UL;
+		max = sum = 0;
+		for(k=0;k<LAT_RUNS;k++)
+		{
+			if(cmd[0] == 'c')		// 'clear' needs something to clear
+			{
+				sprintf(line, "set %u 1", addr[i]);
+				typed(line);
+				bus_run(2*FRAME_US);
+				strcpy(line, "clear");
+			}
+			else
+				sprintf(line, "set %u %u", addr[i], k+1);
+			bus_run(lcg() % FRAME_US);	// Somewhere in a frame
+			us = typed(line);
+			ctl->wireClear();
+			us = onWire(us, addr[i], cmd[0] == 'c' ? 0 : k+1);
+			min = us < min ? us : min;
+			max = us > max ? us : max;
+			sum += us;
+		}
+		sprintf(line, "%u", addr[i]);
+		sprintf(metric, "%s_us_min", cmd);
+		report(metric, line, min, "us");
+		sprintf(metric, "%s_us_avg", cmd);
+		report(metric, line, sum/(double)LAT_RUNS, "us");
+		sprintf(metric, "%s_us_max", cmd);
+		report(metric, line, max, "us");
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// POLL search
+//-----------------------------------------------------------------------------
+
+// Number the Controller printed in front of 'what', -1 if there is none
+static double printed(const char *what, int after)
+{
+	const unsigned char *pc = ctl->pc();
+	unsigned int count = ctl->pcCount(), len = strlen(what), i, k;
+	char text[16];
+
+	for(i=0;i+len<=count;i++)
+	{
+		if(memcmp(pc+i, what, len))
+			continue;
+		if(after)					// "probes, 1.234 s"
+			k = i + len;
+		else						// "123 probes"
+			for(k=i;k>0 && ((pc[k-1] >= '0' && pc[k-1] <= '9') || pc[k-1] == '.');k--);
+		len = (after ? count - k : i - k);
+		if(len >= sizeof(text))
+			len = sizeof(text) - 1;
+		memcpy(text, pc+k, len);
+		text[len] = 0;
+		return atof(text);
+	}
+	return -1;
+}
+
+
+// Addresses the search listed, one per line
+static unsigned int listed(void)
+{
+	const unsigned char *pc = ctl->pc();
+	unsigned int count = ctl->pcCount(), i, n = 0;
+
+	for(i=1;i+2<count;i++)
+		n += (pc[i-1] >= '0' && pc[i-1] <= '9' && pc[i] == ' ' && pc[i+1] == '\r');
+	return n;
+}
+
+
+// 'n' Devices, at random addresses or in one block
+static void search(unsigned int n, int block)
+{
+	BUS_NODE *d;
+	unsigned int addr[BUS_NODES], i, j, a, base;
+	unsigned long us;
+	double t;
+	char param[24];
+
+	bus_close();
+	ctl = bus_load("./controller.so", "controller_main");
+	seed = n;
+	base = 1 + lcg() % (513 - n);
+	for(i=0;i<n;i++)
+	{
+		if(block)
+			a = base + i;
+		else
+		{
+			do
+			{
+				a = 1 + lcg() % 512;
+				for(j=0;j<i && addr[j] != a;j++);
+			} while(j < i);
+		}
+		addr[i] = a;
+		d = bus_load("./device.so", "device_main");
+		bus_devAddr(d, a);
+	}
+	bus_run(600000);
+
+	t = wall();
+	us = typed("poll");
+	bus_until(ctl, " probes, ", 60000000UL);
+	us = bus_now() - us;
+	t = wall() - t;
+	bus_until(ctl, " s\r\n", 100000);	// Rest of the line
+	sprintf(param, "%u/%s", n, block ? "block" : "spread");
+	report("poll_found", param, listed(), "");
+	report("poll_probes", param, printed(" probes", 0), "");
+	report("poll_bus_s", param, printed(" probes, ", 1), "s");
+	report("poll_done_s", param, us/1e6, "s");
+	report("poll_host_s", param, t, "s_wall");
+}
+
+
+//-----------------------------------------------------------------------------
+// Command parser
+//-----------------------------------------------------------------------------
+
+static void parse(void)
+{
+	static const char *line[][2] = {
+		{"set", "set 100 1 2 3 4 5 6 7 8"},
+		{"fill", "fill 1 512 255"},
+		{"get", "get 300"},
+		{"multi", "set 1 10;set 2 20;ramp 3 40 0 255;get 2"},
+		{"error", "foo 1 2"},
+	};
+	void (*processCmd)(char line[]) = bus_sym(ctl, "processCmd");
+	int (*ring_get)(RING *r) = bus_sym(ctl, "ring_get");
+	RING *txRing = bus_sym(ctl, "txRing");
+	char buf[64];
+	unsigned int i, k;
+	double t;
+
+	ctlOnly();
+	for(i=0;i<sizeof(line)/sizeof(line[0]);i++)
+	{
+		t = wall();
+		for(k=0;k<PARSE_RUNS;k++)
+		{
+			strcpy(buf, line[i][1]);	// It cuts the line up
+			processCmd(buf);
+			while(ring_get(txRing) >= 0);	// Reply not sent
+		}
+		report("parse_ns", line[i][0], (wall() - t)*1e9/PARSE_RUNS, "ns_wall");
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Earlier run
+//-----------------------------------------------------------------------------
+
+// Compare with the results of an earlier run; wall times are only shown
+static void compare(const char *file)
+{
+	FILE *f = fopen(file, "r");
+	char text[128], *metric, *param, *value, *unit;
+	unsigned int i;
+	double old, now;
+	int up;
+
+	if(!f)
+	{
+		fprintf(stderr, "bench: can't read %s\n", file);
+		worse = 1;
+		return;
+	}
+	while(fgets(text, sizeof(text), f))
+	{
+		metric = strtok(text, ",");
+		param = strtok(0, ",");
+		value = strtok(0, ",");
+		unit = strtok(0, ",\r\n");
+		if(!metric || !param || !value)
+			continue;
+		for(i=0;i<results;i++)
+		{
+			if(strcmp(result[i].metric, metric) || strcmp(result[i].param, param))
+				continue;
+			old = atof(value);
+			now = result[i].value;
+			if(old == now)
+				break;
+			up = !strcmp(metric, "fps");	// Higher is better only for the frame rate
+			fprintf(stderr, "%-14s %-12s %12.3f -> %12.3f %s%s\n", metric, param, old, now,
+					result[i].unit, (unit && strstr(unit, "_wall")) ? "" :
+					((now > old) == up ? "  better" : "  WORSE"));
+			if((now > old) != up && !(unit && strstr(unit, "_wall")))
+				worse = 1;
+			break;
+		}
+	}
+	fclose(f);
+}
+
+
+//-----------------------------------------------------------------------------
+// MAIN starts here
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+	unsigned int max = DEVICES, n;
+	const char *old = 0;
+	int i;
+
+	for(i=1;i<argc;i++)
+	{
+		if(atoi(argv[i]) > 0)
+			max = atoi(argv[i]);
+		else
+			old = argv[i];
+	}
+	if(max > BUS_NODES-1)
+		max = BUS_NODES-1;
+	setvbuf(stdout, 0, _IOLBF, 0);
+	printf("metric,param,value,unit\n");
+
+	fps();
+	latency("set");
+	latency("clear");
+	for(n=1;n<=max;n*=2)
+	{
+		search(n, 0);
+		search(n, 1);
+	}
+	parse();
+	bus_close();
+
+	if(old)
+		compare(old);
+	return worse;
+}
@@ -0,0 +1,128 @@
+/*! \file binlink_sim.c \brief Runs the binary PC link framing on the host. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'binlink_sim.c'
+// Title		: Binary PC link on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// Frames sent by 'binlink.c' are fed back into its receiver: with typed
+// text around them, with a bad checksum and cut off halfway (the rest must
+// go back to the console after the timeout). The bytes it hands back as
+// BIN_BUSY must be the opcode, length and payload. Exit code is non zero on
+// a mismatch.
+//*****************************************************************************
+
+#include <p33FJ128MC802.h>
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "binlink.h"
+#include "timebase.h"
+
+
+unsigned char line[1024];			// Bytes 'sent' to the PC
+unsigned int lineLen;
+unsigned char frame[BIN_MAX_LEN+3];	// Opcode, length, payload as the receiver sees them
+unsigned int frameLen;
+
+
+static void put(unsigned char data)
+{
+	if(lineLen < sizeof(line))
+		line[lineLen++] = data;
+}
+
+
+// Feed 'len' bytes, count what the console and the frame decoder got
+static void feed(const unsigned char *p, unsigned int len, int *text, int *frames, int *bad)
+{
+	int r;
+
+	while(len--)
+	{
+		r = binlink_rx(*p);
+		sim_run(10);				// 1 Mbit/s is about 10 us a byte
+		if(r == BIN_HEAD) frameLen = 0;
+		else if(r == BIN_BUSY && frameLen < sizeof(frame)) frame[frameLen++] = *p;
+		p++;
+		if(r == BIN_NONE) (*text)++;
+		else if(r == BIN_FRAME) (*frames)++;
+		else if(r == BIN_BAD) (*bad)++;
+	}
+}
+
+
+int main()
+{
+	unsigned char slots[512];
+	unsigned int i, errors = 0;
+	int text = 0, frames = 0, bad = 0;
+
+	sim_init();
+	tb_init();
+	binlink_init(put);
+	for(i=0;i<512;i++)
+		slots[i] = i*3;
+
+	// Full universe with typed text before and after
+	feed((const unsigned char *)"get 1\r", 6, &text, &frames, &bad);
+	lineLen = 0;
+	binlink_send(BIN_UNIVERSE, slots, 512);
+	feed(line, lineLen, &text, &frames, &bad);
+	feed((const unsigned char *)"on\r", 3, &text, &frames, &bad);
+	if(text != 9 || frames != 1 || bad != 0 || frame[0] != BIN_UNIVERSE ||
+			BIN_WORD(frame+1) != 512 || memcmp(frame+3, slots, 512))
+	{
+		printf("universe: text %d, frames %d, bad %d\n", text, frames, bad);
+		errors++;
+	}
+	else
+		printf("universe: 512 slots in %u bytes, text around it untouched\n", lineLen);
+
+	// Range write with the address in front
+	lineLen = 0;
+	binlink_send2(BIN_WRITE, 300, slots, 10);
+	frames = 0;
+	feed(line, lineLen, &text, &frames, &bad);
+	if(frames != 1 || BIN_WORD(frame+3) != 300 || BIN_WORD(frame+1) != 12 || memcmp(frame+5, slots, 10))
+	{
+		printf("write: not decoded\n");
+		errors++;
+	}
+
+	// Bad checksum
+	lineLen = 0;
+	binlink_send(BIN_COMMIT, 0, 0);
+	line[lineLen-1] ^= 1;
+	frames = bad = 0;
+	feed(line, lineLen, &text, &frames, &bad);
+	if(frames != 0 || bad != 1)
+	{
+		printf("checksum: not caught\n");
+		errors++;
+	}
+
+	// Frame cut off, then typing again after the timeout
+	lineLen = 0;
+	binlink_send(BIN_UNIVERSE, slots, 100);
+	text = frames = bad = 0;
+	feed(line, 50, &text, &frames, &bad);
+	sim_run(30000);					// Longer than BIN_TIMEOUT_MS
+	feed((const unsigned char *)"off\r", 4, &text, &frames, &bad);
+	if(text != 4 || frames != 0 || bad != 0)
+	{
+		printf("timeout: text %d, frames %d, bad %d\n", text, frames, bad);
+		errors++;
+	}
+	else
+		printf("timeout: console back after a cut off frame\n");
+
+	printf(errors ? "FAILED\n" : "OK\n");
+	return errors != 0;
+}
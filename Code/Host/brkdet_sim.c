@@ -0,0 +1,144 @@
+/*! \file brkdet_sim.c \brief Runs the Break detector on the host. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'brkdet_sim.c'
+// Title		: Break detector on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// Drives the receive line through a few listen windows after brkdet_arm()
+// and checks what 'brkdet.c' makes of it: a quiet bus must close the window
+// right after the turnaround time (the old loop always waited 60us), short
+// lows must be counted as glitches and not taken for a Break, a real Break
+// must be measured to the us, and a line held low must give up and be
+// counted as stuck, not as a glitch. After an
+// answer, brkdet_idle() must only come once the line was high for
+// BRKDET_IDLE_US. Exit code is non zero on a mismatch.
+//*****************************************************************************
+
+#include <p33FJ128MC802.h>
+#include <stdio.h>
+#include "sim.h"
+#include "brkdet.h"
+#include "timebase.h"
+
+
+#define EDGES 8
+#define CASES 6
+
+
+// A listen window: line levels from brkdet_arm() on, and what must come out
+typedef struct
+{
+	const char *name;
+	unsigned int edgeUs[EDGES];		// Line toggles at these times (0 ends the list)
+	int result;						// brkdet_check()
+	unsigned int doneUs;			// Decided by then
+	unsigned int brkUs;				// Break length, if one
+	unsigned int glitches;			// Glitches counted
+	unsigned int stuck;				// Windows given up on the line
+} LISTEN;
+
+
+static const LISTEN listen[CASES] = {
+	{"quiet",			{0},								BRKDET_QUIET,	BRKDET_TURN_US+2,	0,	0,	0},
+	{"glitch",			{5, 7},								BRKDET_QUIET,	7+BRKDET_TURN_US+2,	0,	1,	0},
+	{"answer",			{10, 106, 130, 150, 170, 200},		BRKDET_BREAK,	108,				96,	0,	0},
+	{"glitch, answer",	{4, 5, 20, 120, 140, 160},			BRKDET_BREAK,	122,				100,	1,	0},
+	{"short low",		{8, 68},							BRKDET_QUIET,	68+BRKDET_TURN_US+2,	0,	1,	0},
+	{"stuck low",		{5},								BRKDET_QUIET,	BRKDET_STUCK_US+2,	0,	0,	1},
+};
+
+
+// Move the line along the case, 'us' after brkdet_arm()
+static void line(const LISTEN *c, unsigned int us)
+{
+	int i;
+
+	for(i=0;i<EDGES && c->edgeUs[i];i++)
+		if(c->edgeUs[i] == us)
+			sim_rxSet(i & 1);		// First edge falls
+}
+
+
+// Last edge of the case
+static unsigned int lastEdge(const LISTEN *c)
+{
+	int i;
+
+	for(i=0;i<EDGES && c->edgeUs[i];i++);
+	return i ? c->edgeUs[i-1] : 0;
+}
+
+
+int main()
+{
+	unsigned int k, us, doneUs, glitches, stuck, errors = 0;
+	int result;
+	const LISTEN *c;
+
+	sim_init();
+	tb_init();
+	brkdet_init();
+	sim_run(10);
+
+	for(k=0;k<CASES;k++)
+	{
+		c = &listen[k];
+		sim_rxSet(1);
+		sim_run(300);				// Bus settled
+		glitches = brkdet_glitches();
+		stuck = brkdet_stuck();
+		brkdet_arm();
+		us = 0;
+		while((result = brkdet_check()) == BRKDET_WAIT && us < 5000)
+		{
+			sim_run(1);
+			line(c, ++us);
+		}
+		doneUs = us;
+		if(result != c->result || us > c->doneUs)
+		{
+			printf("%s: result %d after %u us, expected %d by %u us\n", c->name, result, us, c->result, c->doneUs);
+			errors++;
+		}
+		if(result == BRKDET_BREAK && (brkdet_brkUs() < c->brkUs-1 || brkdet_brkUs() > c->brkUs+1))
+		{
+			printf("%s: Break of %u us measured, %u us sent\n", c->name, brkdet_brkUs(), c->brkUs);
+			errors++;
+		}
+		if(result == BRKDET_BREAK)	// Line must go idle only after the answer
+		{
+			while(!brkdet_idle() && us < 5000)
+			{
+				sim_run(1);
+				line(c, ++us);
+			}
+			if(us < lastEdge(c)+BRKDET_IDLE_US || us > lastEdge(c)+BRKDET_IDLE_US+2)
+			{
+				printf("%s: idle after %u us, last edge at %u us\n", c->name, us, lastEdge(c));
+				errors++;
+			}
+		}
+		brkdet_stop();
+		if(brkdet_glitches() - glitches != c->glitches)
+		{
+			printf("%s: %u glitches counted, %u expected\n", c->name, brkdet_glitches() - glitches, c->glitches);
+			errors++;
+		}
+		if(brkdet_stuck() - stuck != c->stuck)
+		{
+			printf("%s: %u stuck windows counted, %u expected\n", c->name, brkdet_stuck() - stuck, c->stuck);
+			errors++;
+		}
+		printf("%-15s decided after %4u us, Break %3u us\n", c->name, doneUs, result == BRKDET_BREAK ? brkdet_brkUs() : 0);
+	}
+
+	printf(errors ? "FAILED\n" : "OK\n");
+	return errors != 0;
+}
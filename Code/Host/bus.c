@@ -0,0 +1,330 @@
+/*! \file bus.c \brief RS485 bus with whole firmware nodes on the host. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'bus.c'
+// Title		: RS485 bus simulator
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// Every node is a whole firmware (Controller or Device) built with the
+// peripheral model into a shared object. dlopen() gives back the same copy
+// for the same file, so each node loads its own temporary copy: its
+// registers, model and coroutine are its own, and many of them share one
+// process.
+//
+// The bus level is worked out for every 1us from the level each node drives
+// (sim_busOut()). With no driver on, the fail-safe bias holds the line high.
+// A driver going low wins against one going high, as the receivers see it
+// on a real multi-drop line. Every node hears the level the others drove
+// (sim_busIn()) 'lag' us later, BUS_LAG unless bus_lag() says otherwise; its
+// own driver only counts the moment it is on, as DE and /RE are tied. The lag is what makes
+// a few hundred nodes affordable: each node runs 'lag' us in one go
+// (sim_busRun()) while its code and data are in the cache, rather than all
+// of them taking turns every 1us. Everybody hears the same edges the same
+// time after they happen, so bit timing, Break and MAB lengths and who
+// drives when are kept to the 1us; only the turnaround of an answer grows
+// by twice the lag. Counted on the way:
+// - drive:   us with at least one driver on
+// - contend: us with more than one driver on (e.g. several POLL answers)
+// - collide: us with drivers on that disagree on the level
+// - breaks:  low periods of at least 88us
+//*****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include "bus.h"
+
+
+#define BRK_MIN_US 88				// Shortest Break a receiver has to take
+
+
+BUS_NODE node[BUS_NODES];
+unsigned int nodes;
+unsigned long busUs;
+unsigned long driveUs, contendUs, collideUs;
+unsigned long breaks;
+unsigned long lowUs;				// Line low for this long
+unsigned int lag = BUS_LAG;
+unsigned short low[BUS_LAG_MAX];	// Drivers low in the last us, by us
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+static void *need(void *so, const char *name)
+{
+	void *p = dlsym(so, name);
+
+	if(!p)
+	{
+		fprintf(stderr, "bus: %s missing\n", name);
+		exit(2);
+	}
+	return p;
+}
+
+
+// Own copy of an image, so dlopen() gives it its own data
+static void *load_copy(const char *image)
+{
+	char path[] = "/tmp/busXXXXXX";
+	char buf[65536];
+	FILE *in;
+	int fd;
+	size_t n;
+	void *so;
+
+	in = fopen(image, "rb");
+	fd = mkstemp(path);
+	if(!in || fd < 0)
+	{
+		fprintf(stderr, "bus: can't copy %s\n", image);
+		exit(2);
+	}
+	while((n = fread(buf, 1, sizeof(buf), in)) > 0)
+		if(write(fd, buf, n) != (ssize_t)n)
+			break;
+	fclose(in);
+	close(fd);
+	so = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	unlink(path);
+	if(!so)
+	{
+		fprintf(stderr, "bus: %s\n", dlerror());
+		exit(2);
+	}
+	return so;
+}
+
+
+//-----------------------------------------------------------------------------
+// Nodes
+//-----------------------------------------------------------------------------
+
+// New node running the firmware 'entry' (its renamed main()) from 'image'
+BUS_NODE *bus_load(const char *image, const char *entry)
+{
+	BUS_NODE *n;
+	void (*init)(void);
+	void (*start)(int (*)(void));
+
+	if(nodes == BUS_NODES)
+		return 0;
+	n = &node[nodes++];
+	memset(n->out, -1, sizeof(n->out));
+	n->so = load_copy(image);
+	n->busRun = need(n->so, "sim_busRun");
+	n->fwRun = need(n->so, "sim_fwRun");
+	n->pcString = need(n->so, "sim_pcString");
+	n->pcByte = need(n->so, "sim_pcByte");
+	n->pcPending = need(n->so, "sim_pcPending");
+	n->pcCount = need(n->so, "sim_pcCount");
+	n->pc = need(n->so, "sim_pc");
+	n->pcClear = need(n->so, "sim_pcClear");
+	n->wireCount = need(n->so, "sim_wireCount");
+	n->wireClear = need(n->so, "sim_wireClear");
+	init = need(n->so, "sim_init");
+	start = need(n->so, "sim_fwStart");
+	init();
+	n->fwRun(busUs);				// Joins the bus at its time
+	start(need(n->so, entry));
+	return n;
+}
+
+
+// Any symbol of a node: a firmware variable, a function of its model
+void *bus_sym(BUS_NODE *n, const char *name)
+{
+	return need(n->so, name);
+}
+
+
+// Every node off the bus, counters back to 0
+void bus_close(void)
+{
+	while(nodes)
+		dlclose(node[--nodes].so);
+	busUs = driveUs = contendUs = collideUs = 0;
+	breaks = lowUs = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Bus
+//-----------------------------------------------------------------------------
+
+// Time from a level driven to every node hearing it, 1..BUS_LAG_MAX us
+void bus_lag(unsigned int us)
+{
+	if(us >= 1 && us <= BUS_LAG_MAX)
+		lag = us;
+}
+
+
+// Run the bus and every node for 'us' microseconds
+void bus_run(unsigned long us)
+{
+	signed char in[BUS_LAG_MAX];
+	unsigned int i, k, j, q, at, on, lows;
+	BUS_NODE *n;
+
+	while(us)
+	{
+		at = busUs % BUS_LAG_MAX;
+		q = BUS_LAG_MAX - at;		// Up to the end of the history
+		if(q > lag)
+			q = lag;				// Nobody hears what is driven in here
+		if(q > us)
+			q = us;
+
+		for(i=0;i<nodes;i++)
+		{
+			n = &node[i];
+			for(k=0;k<q;k++)		// What the others drove 'lag' us ago
+			{
+				j = (at + k + BUS_LAG_MAX - lag) % BUS_LAG_MAX;
+				in[k] = !(low[j] - (n->out[j] == 0));	// No driver: fail-safe high
+			}
+			n->busRun(in, n->out + at, q);
+		}
+
+		for(k=at;k<at+q;k++)
+		{
+			on = lows = 0;
+			for(i=0;i<nodes;i++)
+			{
+				if(node[i].out[k] >= 0)
+				{
+					on++;
+					lows += !node[i].out[k];
+				}
+			}
+			driveUs += (on != 0);
+			contendUs += (on > 1);
+			collideUs += (lows && lows != on);
+
+			if(lows)
+				lowUs++;
+			else
+			{
+				breaks += (lowUs >= BRK_MIN_US);
+				lowUs = 0;
+			}
+			low[k] = lows;
+		}
+		busUs += q;
+		us -= q;
+	}
+}
+
+
+unsigned long bus_now(void)
+{
+	return busUs;
+}
+
+
+unsigned long bus_driveUs(void)
+{
+	return driveUs;
+}
+
+
+unsigned long bus_contendUs(void)
+{
+	return contendUs;
+}
+
+
+unsigned long bus_collideUs(void)
+{
+	return collideUs;
+}
+
+
+unsigned long bus_breaks(void)
+{
+	return breaks;
+}
+
+
+//-----------------------------------------------------------------------------
+// Device
+//-----------------------------------------------------------------------------
+
+// DIP switches for an address: RB15..RB9, RA4, RB3, active low
+void bus_devAddr(BUS_NODE *n, unsigned int addr)
+{
+	volatile unsigned int *porta = bus_sym(n, "sfrPORTA");
+	volatile unsigned int *portb = bus_sym(n, "sfrPORTB");
+	unsigned int v = ~(addr-1) & 0x1FF;
+
+	*portb = (*portb & ~0xFE08) | ((v >> 2) << 9) | ((v & 1) << 3);
+	*porta = (*porta & ~0x10) | (((v >> 1) & 1) << 4);
+}
+
+
+// RDM device ID (UID bytes 2..5); the firmware has it as a constant
+void bus_devId(BUS_NODE *n, unsigned long id)
+{
+	unsigned char *uid = bus_sym(n, "devUid");
+	long page = sysconf(_SC_PAGESIZE);
+	void *base = (void *)((unsigned long)uid & ~(page-1));
+
+	mprotect(base, 2*page, PROT_READ | PROT_WRITE);
+	uid[2] = id >> 24;
+	uid[3] = id >> 16;
+	uid[4] = id >> 8;
+	uid[5] = id;
+	mprotect(base, 2*page, PROT_READ);
+}
+
+
+//-----------------------------------------------------------------------------
+// Controller
+//-----------------------------------------------------------------------------
+
+// Type a line on the PC side of UART1
+void bus_type(BUS_NODE *n, const char *line)
+{
+	n->pcClear();
+	n->pcString(line);
+	n->pcByte('\r');
+}
+
+
+// PC log has 'text' in it
+int bus_pcHas(BUS_NODE *n, const char *text)
+{
+	unsigned int count = n->pcCount(), len = strlen(text), i;
+
+	for(i=0;i+len<=count;i++)
+		if(!memcmp(n->pc()+i, text, len))
+			return 1;
+	return 0;
+}
+
+
+// Run the bus until 'text' is in the PC log. Returns the us it took, 0 on timeout.
+unsigned long bus_until(BUS_NODE *n, const char *text, unsigned long maxUs)
+{
+	unsigned long start = busUs;
+
+	while(busUs - start < maxUs)
+	{
+		bus_run(1000);
+		if(bus_pcHas(n, text))
+			return busUs - start;
+	}
+	return 0;
+}
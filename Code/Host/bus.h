@@ -0,0 +1,60 @@
+/*! \file bus.h \brief RS485 bus with whole firmware nodes on the host. */
+//*****************************************************************************
+//
+// File Name	: 'bus.h'
+// Title		: RS485 bus simulator
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//*****************************************************************************
+
+#ifndef __BUS_H__
+ #define __BUS_H__
+
+
+#define BUS_NODES 512				// Controller and Devices on one bus
+#define BUS_LAG 16					// us from a level driven to the nodes hearing it
+#define BUS_LAG_MAX 64
+
+
+// One node: a firmware image with its own registers and peripheral model
+typedef struct
+{
+	void *so;
+	void (*busRun)(const signed char in[], signed char out[], unsigned int us);
+	signed char out[BUS_LAG_MAX];	// Level it drove in the last us, by us; -1 for none
+	void (*fwRun)(unsigned long us);
+	void (*pcString)(const char *str);
+	void (*pcByte)(unsigned char data);
+	unsigned int (*pcPending)(void);
+	unsigned int (*pcCount)(void);
+	const unsigned char *(*pc)(void);
+	void (*pcClear)(void);
+	unsigned int (*wireCount)(void);
+	void (*wireClear)(void);
+} BUS_NODE;
+
+
+//Functions
+BUS_NODE *bus_load(const char *image, const char *entry);
+void *bus_sym(BUS_NODE *n, const char *name);
+void bus_close(void);
+
+void bus_lag(unsigned int us);
+void bus_run(unsigned long us);
+unsigned long bus_now(void);
+unsigned long bus_driveUs(void);
+unsigned long bus_contendUs(void);
+unsigned long bus_collideUs(void);
+unsigned long bus_breaks(void);
+
+void bus_devAddr(BUS_NODE *n, unsigned int addr);
+void bus_devId(BUS_NODE *n, unsigned long id);
+
+void bus_type(BUS_NODE *n, const char *line);
+int bus_pcHas(BUS_NODE *n, const char *text);
+unsigned long bus_until(BUS_NODE *n, const char *text, unsigned long maxUs);
+
+#endif
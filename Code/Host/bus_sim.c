@@ -0,0 +1,216 @@
+/*! \file bus_sim.c \brief A Controller and many Devices on one RS485 bus. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'bus_sim.c'
+// Title		: Controller and Devices on the bus
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// 'controller.so' and 'device.so' hold the whole firmware with the model.
+// One Controller and DEVICES Devices (or as many as the first argument
+// says) at spread out addresses share the bus of 'bus.c'. The test types on
+// the Controller's UART1 like the PC would and checks:
+// - a 'set' reaches the Device at that address and no other; the time from
+//   the end of the line to its OC1 moving is the response latency
+// - Breaks counted on the bus give the frame rate
+// - 'poll' finds exactly the Devices on the bus; the search costs bus time
+//   (as the Controller reports it) and wall time here
+// - 'rdm' finds as many UIDs as there are Devices
+// Exit code is non zero on a mismatch.
+//*****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bus.h"
+
+
+#define DEVICES 16
+#define SEARCH_US 60000000UL		// Longest search we wait for
+
+
+BUS_NODE *ctl;
+BUS_NODE *dev[BUS_NODES];
+unsigned int devAddr[BUS_NODES];
+unsigned long seed = 12345;
+int errors = 0;
+
+
+static void check(int ok, const char *what)
+{
+	if(!ok)
+	{
+		printf("%s\n", what);
+		errors++;
+	}
+}
+
+
+// Same sequence on every run
+static unsigned int lcg(void)
+{
+	seed = seed*1103515245UL + 12345;
+	return (seed >> 16) & 0x7FFF;
+}
+
+
+static double wall(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec/1e9;
+}
+
+
+// OC1 of a Device
+static unsigned int oc1(unsigned int i)
+{
+	unsigned int (*get)(unsigned int) = bus_sym(dev[i], "pwm_get");
+
+	return get(0);
+}
+
+
+// Numbers that start a line of the PC log ("\r\n123 "), as a search lists them
+static unsigned int listed(unsigned int out[], unsigned int max)
+{
+	const unsigned char *pc = ctl->pc();
+	unsigned int count = ctl->pcCount(), i, n = 0, v;
+
+	for(i=0;i+2<count;i++)
+	{
+		if(pc[i] != '\r' || pc[i+1] != '\n' || pc[i+2] < '0' || pc[i+2] > '9')
+			continue;
+		for(v=0,i+=2;i<count && pc[i] >= '0' && pc[i] <= '9';i++)
+			v = v*10 + pc[i] - '0';
+		if(i+1 < count && pc[i] == ' ' && (pc[i+1] < 'a' || pc[i+1] > 'z') && n < max)
+			out[n++] = v;				// Not a count like "12 probes"
+	}
+	return n;
+}
+
+
+// Number the Controller printed in front of 'what', 0 if there is none
+static unsigned long reported(const char *what)
+{
+	const unsigned char *pc = ctl->pc();
+	unsigned int count = ctl->pcCount(), len = strlen(what), i, k;
+	unsigned long v = 0, m;
+
+	for(i=0;i+len<=count;i++)
+	{
+		if(memcmp(pc+i, what, len))
+			continue;
+		for(k=i;k>0 && pc[k-1] >= '0' && pc[k-1] <= '9';k--);
+		for(m=1;i>k;m*=10)
+			v += (pc[--i] - '0')*m;
+		break;
+	}
+	return v;
+}
+
+
+static void rig(unsigned int n)
+{
+	unsigned int i, j, a;
+
+	ctl = bus_load("./controller.so", "controller_main");
+	for(i=0;i<n;i++)
+	{
+		do
+		{
+			a = 1 + lcg() % 512;
+			for(j=0;j<i && devAddr[j] != a;j++);
+		} while(j < i);
+		devAddr[i] = a;
+		dev[i] = bus_load("./device.so", "device_main");
+		bus_devAddr(dev[i], a);
+		bus_devId(dev[i], 0x1000 + lcg());
+	}
+	bus_run(600000);				// 500 ms LED blink of every board
+}
+
+
+int main(int argc, char *argv[])
+{
+	unsigned int found[BUS_NODES+2], n, i, j, others;
+	unsigned long us, frames;
+	char line[32];
+	double t;
+
+	setvbuf(stdout, 0, _IOLBF, 0);	// Hundreds of Devices take minutes, show each step
+	n = argc > 1 ? atoi(argv[1]) : DEVICES;
+	if(n < 2 || n > BUS_NODES-1)
+		n = DEVICES;
+	t = wall();
+	rig(n);
+	check(bus_pcHas(ctl, "Welcome."), "start: no welcome");
+	printf("rig          1 Controller, %u Devices, %.1f s wall for %.1f s bus\n", n, wall()-t, bus_now()/1e6);
+
+	// Frame rate
+	frames = bus_breaks();
+	bus_run(1000000);
+	frames = bus_breaks() - frames;
+	check(frames > 20, "dmx: no frames");
+	printf("dmx          %lu frames/s, bus driven %lu%%\n", frames, bus_driveUs()*100/bus_now());
+
+	// A slot reaches its Device
+	sprintf(line, "set %u 255", devAddr[0]);
+	bus_type(ctl, line);
+	while(ctl->pcPending())			// Up to the end of the line
+		bus_run(1);
+	us = bus_now();
+	while(!oc1(0) && bus_now() - us < 200000)
+		bus_run(10);
+	us = bus_now() - us;
+	check(oc1(0) != 0, "set: Device does not follow");
+	bus_run(100000);
+	for(i=1,others=0;i<n;i++)
+		others += (oc1(i) != 0);
+	check(others == 0, "set: other Devices follow");
+	printf("latency      %lu us from the end of 'set' to OC1 of the Device\n", us);
+	bus_type(ctl, "clear");
+	bus_until(ctl, "Ready.", 1000000);
+
+	// POLL search
+	us = bus_now();
+	t = wall();
+	bus_type(ctl, "poll");
+	check(bus_until(ctl, " probes, ", SEARCH_US) != 0, "poll: search did not end");
+	j = listed(found, BUS_NODES+2);
+	check(j == n, "poll: wrong number of Devices");
+	for(i=0;i<j;i++)
+	{
+		for(others=0;others<n && devAddr[others] != found[i];others++);
+		check(others < n, "poll: address not on the bus");
+	}
+	printf("poll         %u of %u found, %lu probes, %.1f s bus, %.1f s wall\n", j, n,
+			reported(" probes"), (bus_now()-us)/1e6, wall()-t);
+
+	// RDM search
+	us = bus_now();
+	t = wall();
+	bus_type(ctl, "rdm");
+	check(bus_until(ctl, " requests, ", SEARCH_US) != 0, "rdm: search did not end");
+	j = listed(found, BUS_NODES+2);
+	if(n > 32)
+	{
+		sprintf(line, "\r\n%u more", n-32);
+		check(j == 32 && bus_pcHas(ctl, line), "rdm: wrong number of UIDs");
+	}
+	else
+		check(j == n, "rdm: wrong number of UIDs");
+	printf("rdm          %u UIDs listed, %lu requests, %.1f s bus, %.1f s wall\n", j, reported(" requests"), (bus_now()-us)/1e6, wall()-t);
+	printf("bus          %lu us contended, %lu us of it colliding\n", bus_contendUs(), bus_collideUs());
+
+	bus_close();
+	printf(errors ? "FAILED\n" : "OK\n");
+	return errors != 0;
+}
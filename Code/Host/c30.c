@@ -0,0 +1,42 @@
+/*! \file c30.c \brief MPLAB C30 library functions glibc doesn't have. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'c30.c'
+// Title		: C30 library on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//*****************************************************************************
+
+#include <p33FJ128MC802.h>
+
+
+// Number as text in 'buf', minus sign only for base 10. Returns 'buf'.
+// 'val' is cut to 16 bits like an int on the chip, so the firmware's
+// buffers (6 characters) are always big enough.
+char *itoa(char *buf, int val, int base)
+{
+	char tmp[17];
+	short v = val;
+	unsigned int u = (unsigned short)v;
+	int n = 0, i = 0;
+
+	if(base == 10 && v < 0)
+	{
+		buf[i++] = '-';
+		u = -v;
+	}
+	do
+	{
+		tmp[n++] = "0123456789ABCDEF"[u % base];
+		u /= base;
+	} while(u);
+	while(n)
+		buf[i++] = tmp[--n];
+	buf[i] = 0;
+	return buf;
+}
@@ -0,0 +1,348 @@
+/*! \file controller_sim.c \brief Runs the whole Controller firmware on the host. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'controller_sim.c'
+// Title		: Controller firmware on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// 'main.c' of the Controller is built with its main() renamed to
+// controller_main() and runs as a coroutine on the peripheral model. The
+// test types on UART1 like the PC would and checks:
+// - the welcome text comes after the 500 ms LED blink, frames are on the wire
+// - 'set' changes the slots of the next frame, 'get' reads one back
+// - 'clear' puts the frame back to zero, a bad cmd gives the error text
+// - several cmds in one line go out in one frame, also when the line is
+//   LINE_MAX characters of them; a line with one bad cmd changes nothing
+// - 'fill', 'setrange', 'copy' and 'ramp' write the right slots, a 'set'
+//   with a list of values too long for the universe changes nothing
+// - 'max 0' ends the frame at the highest written slot, 'clear' takes it
+//   back to the floor
+// - a line of LINE_MAX characters runs, a longer one gives the error text
+//   and none of it runs
+// - binary frames: a universe write leaves 'max' alone, BIN_WRITE,
+//   BIN_READ, BIN_MAX, BIN_COMMIT after 'auto 0', and the error replies for
+//   a bad checksum and a length out of range
+// Exit code is non zero on a mismatch.
+//*****************************************************************************
+
+#include <p33FJ128MC802.h>
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "binlink.h"
+
+
+#define LINE_MAX 517				// As in 'main.h'
+
+int controller_main(void);
+
+unsigned char frame[513];			// Slots of the last whole frame on the wire
+int errors = 0;
+
+
+static void check(int ok, const char *what)
+{
+	if(!ok)
+	{
+		printf("%s\n", what);
+		errors++;
+	}
+}
+
+
+// Slots of the last frame ended by a Break, -1 if there is none
+static int lastFrame(void)
+{
+	const SIM_WIRE *w = sim_wire();
+	int i, end = -1, start = -1;
+
+	for(i=sim_wireCount()-1;i>=0;i--)
+	{
+		if(w[i].data != SIM_BREAK)
+			continue;
+		if(end < 0)
+			end = i;
+		else
+		{
+			start = i;
+			break;
+		}
+	}
+	if(start < 0 || end - start < 2)
+		return -1;
+	memset(frame, 0, sizeof(frame));
+	for(i=start+1;i<end && i-start-1 <= 512;i++)
+		frame[i-start-1] = w[i].data;
+	return end - start - 2;
+}
+
+
+// A whole frame in the log with slot 'a' at 'v' but not slot 'b', or the
+// other way round: a cmd line went out in pieces
+static int torn(unsigned int a, unsigned int b, unsigned char v)
+{
+	const SIM_WIRE *w = sim_wire();
+	int i, start = -1;
+
+	for(i=0;i<(int)sim_wireCount();i++)
+	{
+		if(w[i].data != SIM_BREAK)
+			continue;
+		if(start >= 0 && i-start-2 >= (int)b && (w[start+1+a].data == v) != (w[start+1+b].data == v))
+			return 1;
+		start = i;
+	}
+	return 0;
+}
+
+
+// PC log has these bytes in it
+static int pcHasBytes(const unsigned char *data, unsigned int len)
+{
+	unsigned int n = sim_pcCount(), i;
+
+	for(i=0;i+len<=n;i++)
+		if(!memcmp(sim_pc()+i, data, len))
+			return 1;
+	return 0;
+}
+
+
+static int pcHas(const char *text)
+{
+	return pcHasBytes((const unsigned char *)text, strlen(text));
+}
+
+
+// Let the Controller work on what was sent
+static void sent(void)
+{
+	while(sim_pcPending())			// Long lines take a while at 19200 baud
+		sim_fwRun(1000);
+	sim_wireClear();				// Only frames from here on fit the log
+	sim_fwRun(100000);
+}
+
+
+// Type a line
+static void type(const char *line)
+{
+	sim_pcClear();
+	sim_pcString(line);
+	sim_pcByte('\r');
+	sent();
+}
+
+
+// Binary frame; 'sum' is added to the checksum (0 for a good one)
+static void binFrame(unsigned char op, const unsigned char *data, unsigned int len, unsigned char sum)
+{
+	unsigned int i;
+
+	sim_pcClear();
+	sim_pcByte(BIN_SYNC);
+	sim_pcByte(op);
+	sim_pcByte(len & 0xFF);
+	sim_pcByte(len >> 8);
+	sum += op + (len & 0xFF) + (len >> 8);
+	for(i=0;i<len;i++)
+	{
+		sim_pcByte(data[i]);
+		sum += data[i];
+	}
+	sim_pcByte(-sum);
+	sent();
+}
+
+
+// Reply without payload, or a BIN_ERROR for 'op'
+static int binAck(unsigned char op)
+{
+	const unsigned char ack[] = {BIN_SYNC, op|BIN_REPLY, 0, 0, -(op|BIN_REPLY)};
+
+	return pcHasBytes(ack, sizeof(ack));
+}
+
+
+static int binError(unsigned char op, unsigned char err)
+{
+	const unsigned char nak[] = {BIN_SYNC, BIN_ERROR, 2, 0, op, err, -(BIN_ERROR+2+op+err)};
+
+	return pcHasBytes(nak, sizeof(nak));
+}
+
+
+int main()
+{
+	static const unsigned char readReply[] = {BIN_SYNC, BIN_READ|BIN_REPLY, 5, 0, 300 & 0xFF, 300 >> 8, 1, 2, 3};
+	unsigned char data[BIN_MAX_LEN];
+	char line[LINE_MAX+16];
+	int n, k, ok;
+
+	sim_init();
+	sim_fwStart(controller_main);
+
+	sim_fwRun(600000);
+	check(pcHas("Welcome."), "start: no welcome");
+	check(lastFrame() == 512 && frame[0] == 0, "start: no frames");
+	printf("start        welcome after 500 ms, %d slot frames\n", lastFrame());
+
+	type("set 1 255");
+	check(pcHas("Ready."), "set: no Ready");
+	n = lastFrame();
+	check(n == 512 && frame[1] == 255 && frame[2] == 0, "set: frame wrong");
+
+	type("set 10 1 2 3;set 512 99");
+	n = lastFrame();
+	check(n == 512 && frame[10] == 1 && frame[12] == 3 && frame[512] == 99, "two cmds: frame wrong");
+
+	type("get 11");
+	check(pcHas("\r\n2"), "get: wrong value");
+
+	type("clear");
+	n = lastFrame();
+	check(n == 512 && frame[1] == 0 && frame[512] == 0, "clear: frame not zero");
+
+	type("foo 1");
+	check(pcHas("Error"), "bad cmd: no error");
+	printf("cmds         set, get, clear and errors seen on UART1 and the wire\n");
+
+	// Longest line runs; one character more and nothing of it does
+	memset(line, ' ', LINE_MAX);
+	memcpy(line, "set 7 1 2 3", 11);
+	line[LINE_MAX] = 0;
+	type(line);
+	n = lastFrame();
+	check(pcHas("Ready.") && n == 512 && frame[7] == 1 && frame[9] == 3, "LINE_MAX: longest line not run");
+	type("clear");
+	memcpy(line, "set 1", 5);
+	for(n=5;n<LINE_MAX-2;n+=2)
+		memcpy(line+n, " 5", 2);
+	memcpy(line+n, " 25", 4);		// Cut at LINE_MAX this would run as '2', then '5'
+	type(line);
+	n = lastFrame();
+	check(pcHas("Error") && !pcHas("Ready.") && n == 512 && frame[1] == 0, "LINE_MAX: part of a long line ran");
+	type("stats");
+	check(pcHas("rx lost 1"), "LINE_MAX: long line not counted");
+	printf("line max     %d characters run, a longer line is dropped\n", LINE_MAX);
+
+	// Line of LINE_MAX characters, all cmds: one frame
+	type("clear");
+	for(n=0,k=1;n+8<=LINE_MAX;k++)
+		n += sprintf(line+n, "set %d 9;", k);
+	memset(line+n, ' ', LINE_MAX-n);
+	line[LINE_MAX] = 0;
+	type(line);
+	n = lastFrame();
+	check(pcHas("Ready.") && n == 512 && frame[1] == 9 && frame[k-1] == 9 && frame[k] == 0, "batch: not every cmd ran");
+	check(!torn(1, k-1, 9), "batch: cmds in more than one frame");
+	printf("batch        %d cmds in a line of %d characters, one frame\n", k-1, LINE_MAX);
+
+	// One bad cmd: nothing of the line runs
+	type("clear");
+	type("set 1 255;bogus");
+	n = lastFrame();
+	check(pcHas("Error") && !pcHas("Ready.") && n == 512 && frame[1] == 0, "rejected batch: first cmd ran");
+	type("set 1 255;max 0;set 510 1 2 3 4");
+	n = lastFrame();
+	check(pcHas("Error") && n == 512 && frame[1] == 0, "rejected batch: cmds before a bad range ran");
+	printf("batch        a line with a bad cmd changes nothing\n");
+
+	// Range cmds
+	type("clear");
+	type("fill 20 29 7");
+	n = lastFrame();
+	check(n == 512 && frame[19] == 0 && frame[20] == 7 && frame[29] == 7 && frame[30] == 0, "fill: frame wrong");
+	type("setrange 40 46 1 2 3");
+	n = lastFrame();
+	check(n == 512 && frame[39] == 0 && frame[40] == 1 && frame[42] == 3 && frame[43] == 1 && frame[46] == 1 && frame[47] == 0,
+			"setrange: frame wrong");
+	type("copy 40 100 7");
+	n = lastFrame();
+	check(n == 512 && frame[100] == 1 && frame[102] == 3 && frame[106] == 1 && frame[107] == 0 && frame[40] == 1, "copy: frame wrong");
+	type("ramp 50 54 0 200");
+	n = lastFrame();
+	check(n == 512 && frame[50] == 0 && frame[51] == 50 && frame[52] == 100 && frame[53] == 150 && frame[54] == 200, "ramp: frame wrong");
+	type("set 60 1 2 3 4 5 6 7 8 9 10");
+	n = lastFrame();
+	check(pcHas("Ready.") && n == 512 && frame[60] == 1 && frame[69] == 10 && frame[70] == 0, "set list: frame wrong");
+	type("set 510 1 2 3 4");
+	n = lastFrame();
+	check(pcHas("Error") && n == 512 && frame[510] == 0, "set list: ran past slot 512");
+	type("fill 30 20 1");
+	check(pcHas("Error"), "fill: backwards range taken");
+	type("setrange 1 2 10 20 30");
+	n = lastFrame();
+	check(pcHas("Error") && n == 512 && frame[1] == 0 && frame[2] == 0, "setrange: list longer than the range taken");
+	printf("ranges       fill, setrange, copy, ramp and value lists on the wire\n");
+
+	// Frame length from the highest written slot
+	type("clear;max 0");
+	n = lastFrame();
+	check(n == 24, "max 0: not the floor after clear");
+	type("set 100 1");
+	n = lastFrame();
+	check(n == 100 && frame[100] == 1, "max 0: frame not up to slot 100");
+	type("set 30 1");
+	check(lastFrame() == 100, "max 0: frame got shorter");
+	type("clear");
+	check(lastFrame() == 24, "max 0: clear didn't shorten the frame");
+	type("max 512");
+	check(lastFrame() == 512, "max: fixed length not back");
+	printf("max 0        frame follows the highest written slot\n");
+
+	// Binary link
+	memset(data, 5, 100);
+	binFrame(BIN_UNIVERSE, data, 100, 0);
+	n = lastFrame();
+	check(binAck(BIN_UNIVERSE) && n == 512 && frame[1] == 5 && frame[100] == 5 && frame[101] == 0, "bin universe: frame wrong");
+	data[0] = 300 & 0xFF;
+	data[1] = 300 >> 8;
+	data[2] = 1;
+	data[3] = 2;
+	data[4] = 3;
+	binFrame(BIN_WRITE, data, 5, 0);
+	n = lastFrame();
+	check(binAck(BIN_WRITE) && n == 512 && frame[300] == 1 && frame[302] == 3, "bin write: frame wrong");
+	data[2] = 3;
+	data[3] = 0;
+	binFrame(BIN_READ, data, 4, 0);
+	check(pcHasBytes(readReply, sizeof(readReply)), "bin read: wrong reply");
+	data[0] = data[1] = 0;
+	binFrame(BIN_MAX, data, 2, 0);
+	check(binAck(BIN_MAX) && lastFrame() == 302, "bin max 0: frame not up to slot 302");
+	data[0] = 600 & 0xFF;
+	data[1] = 600 >> 8;
+	binFrame(BIN_MAX, data, 2, 0);
+	check(binError(BIN_MAX, BIN_ERR_RANGE) && lastFrame() == 302, "bin max 600: taken");
+	data[0] = 512 & 0xFF;
+	data[1] = 512 >> 8;
+	binFrame(BIN_MAX, data, 2, 0);
+	check(binAck(BIN_MAX) && lastFrame() == 512, "bin max 512: not taken");
+	binFrame(BIN_UNIVERSE, data, 24, 0);
+	check(lastFrame() == 512, "bin universe: 'max' changed");
+	binFrame(BIN_UNIVERSE, data, 24, 1);
+	check(binError(BIN_UNIVERSE, BIN_ERR_CHECKSUM), "bin checksum: no error");
+
+	type("auto 0");
+	data[0] = 400 & 0xFF;
+	data[1] = 400 >> 8;
+	data[2] = 77;
+	binFrame(BIN_WRITE, data, 3, 0);
+	n = lastFrame();
+	ok = (n == 512 && frame[400] == 0);
+	binFrame(BIN_COMMIT, data, 0, 0);
+	n = lastFrame();
+	check(ok && binAck(BIN_COMMIT) && n == 512 && frame[400] == 77, "bin commit: frame wrong");
+	type("auto 1");
+	printf("binary       universe, write, read, max and commit frames\n");
+
+	printf(errors ? "FAILED\n" : "OK\n");
+	return errors != 0;
+}
@@ -0,0 +1,40 @@
+/*! \file delay.c \brief Host twin of 'delay.s'. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'delay.c'
+// Title		: Delay functions on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// Same calls as 'delay.s' in Controller and Device. The time is model time:
+// the peripherals and their interrupts run on meanwhile, like on the chip.
+//*****************************************************************************
+
+#include <p33FJ128MC802.h>
+#include "sim.h"
+
+
+void wait_us(unsigned int n)
+{
+	while(n--)
+		sim_spin();
+}
+
+
+void wait_ms(unsigned int n)
+{
+	while(n--)
+		wait_us(1000);
+}
+
+
+// One bit at 19200 baud. The model has 1us steps, so it's 52us.
+void wait_52083ns(void)
+{
+	wait_us(52);
+}
@@ -0,0 +1,147 @@
+/*! \file device_sim.c \brief Runs the whole Device firmware on the host. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'device_sim.c'
+// Title		: Device firmware on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// 'main.c' of the Device is built with its main() renamed to device_main()
+// and runs as a coroutine on the peripheral model, with the DIP switches
+// on PORTA and PORTB. The test checks:
+// - a DMX frame drives OC1 from the slot at the DIP switch address
+// - moving the DIP switches moves the address (Change Notification)
+// - a POLL with this address set gets the address back after a Break
+// - an RDM request for a sub-device is NACKed with NR_SUB_DEVICE_OUT_OF_RANGE
+// Exit code is non zero on a mismatch.
+//*****************************************************************************
+
+#include <p33FJ128MC802.h>
+#include <stdio.h>
+#include "sim.h"
+#include "pwm.h"
+#include "rdm.h"
+
+
+#define SLOT_US 44					// One byte at 250 kbaud, 8N2
+
+
+int device_main(void);
+extern const unsigned char devUid[RDM_UID_LEN];
+
+int errors = 0;
+
+
+static void check(int ok, const char *what)
+{
+	if(!ok)
+	{
+		printf("%s\n", what);
+		errors++;
+	}
+}
+
+
+// DIP switches for an address: RB15..RB9, RA4, RB3, active low
+static void dip(unsigned int addr)
+{
+	unsigned int v = ~(addr-1) & 0x1FF;
+
+	PORTB = (PORTB & ~0xFE08) | ((v >> 2) << 9) | ((v & 1) << 3);
+	PORTAbits.RA4 = (v >> 1) & 1;
+}
+
+
+// DMX frame, 512 slots: 'level' at 'addr', 0 elsewhere
+static void dmxFrame(unsigned int addr, unsigned char level)
+{
+	unsigned int k;
+
+	sim_rxByte(SIM_BREAK);
+	sim_rxByte(0x00);
+	for(k=1;k<=512;k++)
+		sim_rxByte(k == addr ? level : 0);
+	sim_fwRun(100 + 513*SLOT_US);
+}
+
+
+// Level OC1 ends up with, once faded
+static unsigned int output(void)
+{
+	sim_fwRun(50000);
+	return pwm_get(0);
+}
+
+
+int main()
+{
+	static const unsigned char ctlUid[RDM_UID_LEN] = {0x7F, 0xF0, 0x80, 0, 0, 0};
+	unsigned char pkt[RDM_PKT_MAX];
+	const SIM_WIRE *w;
+	unsigned int k, n, sum;
+
+	sim_init();
+	dip(10);
+	sim_fwStart(device_main);
+	sim_fwRun(600000);				// 500 ms LED blink
+
+	// Slot at the address drives OC1
+	dmxFrame(10, 255);
+	check(output() == 0xFFFF, "address 10: OC1 not on");
+	dmxFrame(10, 0);
+	check(output() == 0, "address 10: OC1 not off");
+	dmxFrame(11, 255);
+	check(output() == 0, "address 10: OC1 follows slot 11");
+	printf("dmx          OC1 follows slot 10\n");
+
+	// DIP switches moved
+	dip(300);
+	sim_fwRun(50000);				// Debounce
+	dmxFrame(10, 255);
+	check(output() == 0, "address 300: OC1 follows slot 10");
+	dmxFrame(300, 255);
+	check(output() == 0xFFFF, "address 300: OC1 not on");
+	printf("dip          moved to 300, OC1 follows it\n");
+
+	// POLL with this address set
+	sim_wireClear();
+	sim_rxByte(SIM_BREAK);
+	sim_rxByte(0xF0);
+	for(k=1;k<=512;k++)
+		sim_rxByte(k == 300);
+	sim_fwRun(100 + 513*SLOT_US + 2000);
+	w = sim_wire();
+	n = sim_wireCount();
+	check(n == 10 && w[0].data == SIM_BREAK && w[1].data == 0xAA, "poll: no answer");
+	if(n == 10)
+		check(((w[2].data & w[3].data) << 8 | (w[4].data & w[5].data)) == 300, "poll: wrong address");
+	printf("poll         answered with %u bytes after a Break\n", n ? n-1 : 0);
+
+	// RDM GET DEVICE_INFO for sub-device 1, there is none
+	n = rdm_build(pkt, devUid, ctlUid, 1, 1, RDM_GET, RDM_PID_DEVINFO, 0, 0);
+	pkt[RDM_SUBDEV+1] = 1;
+	sum = ((pkt[n-2] << 8) | pkt[n-1]) + 1;
+	pkt[n-2] = sum >> 8;
+	pkt[n-1] = sum & 0xFF;
+	sim_wireClear();
+	sim_rxByte(SIM_BREAK);
+	for(k=0;k<n;k++)
+		sim_rxByte(pkt[k]);
+	sim_fwRun(100 + n*SLOT_US + 5000);
+	w = sim_wire();
+	n = sim_wireCount();
+	for(k=1;k<n && k<=RDM_PKT_MAX;k++)
+		pkt[k-1] = w[k].data;
+	check(n > RDM_PD+2 && w[0].data == SIM_BREAK && rdm_check(pkt, n-1), "rdm sub-device: no answer");
+	check(pkt[RDM_PORT] == RDM_NACK && pkt[RDM_PDL] == 2 && ((pkt[RDM_PD] << 8) | pkt[RDM_PD+1]) == RDM_NR_SUB_DEVICE,
+			"rdm sub-device: not NACKed with NR_SUB_DEVICE_OUT_OF_RANGE");
+	printf("rdm          sub-device 1 NACKed with reason 0x%04X\n", (pkt[RDM_PD] << 8) | pkt[RDM_PD+1]);
+
+	printf(errors ? "FAILED\n" : "OK\n");
+	return errors != 0;
+}
@@ -0,0 +1,228 @@
+/*! \file discover_sim.c \brief Runs the Device discovery on the host. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'discover_sim.c'
+// Title		: Device discovery on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// 'discover.c' searches a model bus: a probe is answered if a Device which
+// is not found yet sits in the range, and it takes as long as a 0xF1 POLL
+// frame (window and mute mask) plus the answer window. Devices send their
+// address after the Break; if several answer, the bus carries the AND of
+// their bytes (a low driver wins). Every rig is searched with that and with
+// Devices which only send a Break (old firmware). Every rig must be found exactly, in
+// fewer probes than the old search which went back to 1..512 after every
+// Device. A Device which comes up halfway through the walk must be picked up
+// by the last whole range probe. Rigs with every 10th and with all 512
+// addresses must work too. Exit code is non zero on a mismatch.
+//*****************************************************************************
+
+#include <p33FJ128MC802.h>
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "discover.h"
+#include "timebase.h"
+
+
+#define SLOT_US 44					// One slot at 250 kbit/s
+#define POLL_US (96+20+5*SLOT_US+60)	// Break, MAB, start code, min, max, answer window
+#define REPLY_US (96+20+DISC_REPLY_LEN*SLOT_US)	// Break, MAB and address of the answer
+#define RIGS 8
+#define RIG_MAX 10
+#define RIG_TENTH 6					// Rigs made up in main()
+#define RIG_ALL 7
+
+
+unsigned char present[513];			// Devices on the bus
+unsigned char muted[513];			// Old search: found ones
+unsigned int lateAddr;				// Device which comes up after 'lateAfter' probes
+unsigned int lateAfter;
+unsigned int probes;
+int oldFirmware;					// Devices answer with a Break only
+
+
+// What Device 'addr' sends after its Break (sendAddr() of the Device)
+static void reply(unsigned int addr, unsigned char p[])
+{
+	unsigned int i, sum = 0;
+
+	p[0] = DISC_SEPARATOR;
+	p[1] = (addr >> 8) | 0xAA;
+	p[2] = (addr >> 8) | 0x55;
+	p[3] = (addr & 0xFF) | 0xAA;
+	p[4] = (addr & 0xFF) | 0x55;
+	for(i=1;i<5;i++)
+		sum += p[i];
+	p[5] = (sum >> 8) | 0xAA;
+	p[6] = (sum >> 8) | 0x55;
+	p[7] = (sum & 0xFF) | 0xAA;
+	p[8] = (sum & 0xFF) | 0x55;
+}
+
+
+static unsigned int probe(unsigned int min, unsigned int max)
+{
+	unsigned char bus[DISC_REPLY_LEN], one[DISC_REPLY_LEN];
+	unsigned int i, j, n = 0;
+
+	probes++;
+	if(lateAddr && probes > lateAfter)
+		present[lateAddr] = 1;
+	sim_run(POLL_US + ((max-min)/8+1)*SLOT_US);	// Plus the mute mask
+
+	memset(bus, 0xFF, sizeof(bus));	// Idle line
+	for(i=min;i<=max;i++)
+	{
+		if(present[i] && !disc_found(i) && !muted[i])
+		{
+			reply(i, one);
+			for(j=0;j<DISC_REPLY_LEN;j++)
+				bus[j] &= one[j];
+			n++;
+		}
+	}
+	if(!n)
+		return DISC_QUIET;
+	sim_run(REPLY_US);
+	return disc_decode(bus, oldFirmware ? 0 : DISC_REPLY_LEN);
+}
+
+
+// The search 'findDevice()' used to do, for comparison
+static unsigned int oldSearch(void)
+{
+	unsigned int min = 1, max, temp;
+
+	memset(muted, 0, sizeof(muted));
+	probes = 0;
+	while(probe(1,512))
+	{
+		max = 512;
+		while(1)
+		{
+			if(probe(min,max))
+			{
+				if(min == max)
+				{
+					muted[min] = 1;
+					break;
+				}
+				max = (min+max-1)>>1;
+			}
+			else
+			{
+				temp = min;
+				min = max+1;
+				max = (max*2)+1-temp;
+			}
+		}
+	}
+	memset(muted, 0, sizeof(muted));
+	return probes;
+}
+
+
+int main()
+{
+	static const unsigned int rig[RIGS][RIG_MAX] = {
+		{0},
+		{1},
+		{512},
+		{3, 4},
+		{1, 2, 3, 4, 5, 6, 7, 8, 9, 10},
+		{7, 60, 61, 130, 255, 256, 300, 411, 500, 512},
+	};
+	unsigned char bad[DISC_REPLY_LEN];
+	unsigned int r, i, n, addr, old, errors = 0;
+
+	sim_init();
+	tb_init();
+	disc_init(probe);
+
+	reply(300, bad);
+	if(disc_decode(bad, DISC_REPLY_LEN) != 300)
+	{
+		printf("address 300 not decoded\n");
+		errors++;
+	}
+	bad[8] ^= 0x02;					// Checksum off by one bit
+	if(disc_decode(bad, DISC_REPLY_LEN) != DISC_NOADDR || disc_decode(bad, 5) != DISC_NOADDR)
+	{
+		printf("spoilt address decoded\n");
+		errors++;
+	}
+
+	for(r=0;r<2*RIGS;r++)
+	{
+		oldFirmware = r >= RIGS;
+		if(r == RIGS)
+			printf("Devices without address:\n");
+		memset(present, 0, sizeof(present));
+		n = 0;
+		for(i=1;i<=512;i++)
+		{
+			if(r%RIGS == RIG_ALL || (r%RIGS == RIG_TENTH && i%10 == 1))
+				present[i] = 1;
+		}
+		if(r%RIGS < RIG_TENTH)
+			for(;n<RIG_MAX && rig[r%RIGS][n];n++)
+				present[rig[r%RIGS][n]] = 1;
+		else
+			for(i=1;i<=512;i++)
+				n += present[i];
+		lateAddr = 0;
+		old = (r%RIGS == RIG_ALL) ? 0 : oldSearch();	// Too slow to wait for
+
+		probes = 0;
+		if(disc_run() != n)
+		{
+			printf("rig %u: %u of %u Devices found\n", r, disc_count(), n);
+			errors++;
+			continue;
+		}
+		for(addr=disc_next(0),i=0;addr;addr=disc_next(addr),i++)
+		{
+			if(!present[addr])
+			{
+				printf("rig %u: Device %u is at %u\n", r, i, addr);
+				errors++;
+			}
+		}
+		if(i != n)
+		{
+			printf("rig %u: %u addresses listed\n", r, i);
+			errors++;
+		}
+		if(n > 1 && old && disc_probes() >= old)
+		{
+			printf("rig %u: %u probes, the old search needed %u\n", r, disc_probes(), old);
+			errors++;
+		}
+		printf("rig %u: %3u Devices, %4u probes (old %3u), %5lu ms on the bus\n",
+				r%RIGS, n, disc_probes(), old, disc_busUs()/1000);
+	}
+
+	oldFirmware = 1;				// Else 100 is found before the walk gets anywhere
+	memset(present, 0, sizeof(present));	// 40 comes up after the walk passed it
+	present[100] = 1;
+	lateAddr = 40;
+	lateAfter = 5;
+	probes = 0;
+	if(disc_run() != 2 || disc_next(0) != 40 || disc_next(40) != 100)
+	{
+		printf("late Device: %u found\n", disc_count());
+		errors++;
+	}
+	else
+		printf("late Device: found with %u probes\n", disc_probes());
+
+	printf(errors ? "FAILED\n" : "OK\n");
+	return errors != 0;
+}
@@ -0,0 +1,243 @@
+/*! \file dmxrx_sim.c \brief Runs the Device DMX receiver on the host. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'dmxrx_sim.c'
+// Title		: Device DMX receiver on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// Feeds packets into the UART2 receiver and checks what 'dmxrx.c' makes of
+// them:
+// - the window must reach 'frame' only once the frame is over (its last
+//   slot, or the next Break), and hold the right slots
+// - once a shorter frame length is known, 'frame' must come right after its
+//   last slot without waiting for the next Break
+// - a frame error anywhere in a frame must throw it away
+// - a frame too short for the window, or a start code nobody wants, must
+//   give nothing
+// - a DMXRX_ALL packet must come out whole through dmxrx_getc(). One cut
+//   short by a Break, with bytes lost in an overrun or with more bytes than
+//   the ring holds while nobody reads, must make dmxrx_ok() fail; the ring
+//   counts what it had to drop
+// Exit code is non zero on a mismatch.
+//*****************************************************************************
+
+#include <p33FJ128MC802.h>
+#include <stdio.h>
+#include "sim.h"
+#include "dmxrx.h"
+
+
+#define BAUD_250K 9					// UART2-->(40M/16/250K)-1
+#define SLOT_US 44					// One byte at 250 kbaud, 8N2
+
+
+unsigned char seen[DMXRX_WINDOW];	// Last window handed to 'frame'
+unsigned int seenN;
+unsigned int frames;
+unsigned long frameUs;				// Model time of the last 'frame'
+unsigned int starts;
+int errors = 0;
+
+
+// Policies of the start codes used here
+static int start(unsigned char code)
+{
+	starts++;
+	if(code == 0x00)
+		return DMXRX_MINE;
+	if(code == 0xCC)
+		return DMXRX_ALL;
+	return DMXRX_SKIP;
+}
+
+
+static void frame(const unsigned char slots[], unsigned int n)
+{
+	unsigned int i;
+
+	for(i=0;i<n;i++)
+		seen[i] = slots[i];
+	seenN = n;
+	frames++;
+	frameUs = sim_now();
+}
+
+
+// Break, start code and 'n' slots; slot k carries (k + salt) & 0xFF.
+// Slot 'bad' (if not 0) has a frame error.
+static void packetBad(unsigned char code, unsigned int n, unsigned int salt, unsigned int bad)
+{
+	unsigned int k;
+
+	sim_rxByte(SIM_BREAK);
+	sim_rxByte(code);
+	for(k=1;k<=n;k++)
+		sim_rxByte(((k + salt) & 0xFF) | (k == bad ? SIM_FERR : 0));
+}
+
+
+static void packet(unsigned char code, unsigned int n, unsigned int salt)
+{
+	packetBad(code, n, salt, 0);
+}
+
+
+// Bytes on the wire from 't0' to the last 'frame' (Break as 100us)
+static unsigned int bytesTo(unsigned long t0)
+{
+	return (frameUs - t0 - 100) / SLOT_US;
+}
+
+
+static void drain(void)
+{
+	while(sim_rxPending())
+		sim_run(10);
+	sim_run(100);
+}
+
+
+static void check(int ok, const char *what)
+{
+	if(!ok)
+	{
+		printf("%s\n", what);
+		errors++;
+	}
+}
+
+
+int main()
+{
+	unsigned int k, n;
+	unsigned long t0;
+	int code, ok;
+
+	sim_init();
+	U2BRG = BAUD_250K;				// uart2_init()
+	U2MODE = 0x8001;
+	U2STA = 0x0400;
+	dmxrx_init(start, frame);
+	dmxrx_window(100, 4);
+
+	// Window of a full frame, 'frame' after its last slot
+	t0 = sim_now();
+	packet(0x00, 512, 7);
+	drain();
+	check(frames == 1 && seenN == 4, "window: not handed over once");
+	for(k=0;k<4;k++)
+		check(seen[k] == ((100 + k + 7) & 0xFF), "window: wrong slot");
+	n = bytesTo(t0);
+	check(n >= 513 && n <= 515, "window: not at the end of the frame");
+	printf("window       slots 100..103 handed over after %u bytes\n", n);
+
+	// New window, every frame is handed over
+	dmxrx_window(1, DMXRX_WINDOW);
+	packet(0x00, 512, 1);
+	packet(0x00, 512, 2);
+	drain();
+	check(frames == 3 && seenN == DMXRX_WINDOW && seen[0] == 3, "slot 1 window: frames lost");
+
+	// Shorter frames: the first waits for the next Break, the others don't
+	dmxrx_window(100, 4);
+	packet(0x00, 200, 3);
+	drain();
+	check(frames == 3, "short frame: handed over before its Break");
+	t0 = sim_now();
+	packet(0x00, 200, 4);
+	sim_run(100 + 2*SLOT_US);		// Break and start code
+	check(frames == 4 && seen[0] == ((100 + 3) & 0xFF), "short frame: not handed over at the Break");
+	drain();
+	n = bytesTo(t0);
+	check(frames == 5 && seen[0] == ((100 + 4) & 0xFF) && n >= 201 && n <= 203, "short frame: not handed over after its last slot");
+	printf("short frames handed over after %u bytes\n", n);
+
+	// Frame error after the window: whole frame thrown away
+	n = dmxrx_dropped();
+	packetBad(0x00, 200, 6, 150);
+	packet(0x00, 200, 7);
+	drain();
+	check(frames == 6 && seen[0] == ((100 + 7) & 0xFF), "frame error: frame shown");
+	check(dmxrx_dropped() == n+1, "frame error: not counted");
+
+	// Frame too short for the window
+	dmxrx_window(500, 4);
+	packet(0x00, 501, 0);
+	sim_rxByte(SIM_BREAK);
+	drain();
+	check(frames == 6, "too short: window handed over");
+
+	// Start code nobody wants
+	n = starts;
+	packet(0x17, 40, 0);
+	drain();
+	check(frames == 6 && starts == n+1 && dmxrx_packet() < 0, "skipped packet: came through");
+
+	// Whole packet for the main loop
+	packet(0xCC, 24, 0x40);
+	packet(0x00, 512, 0);
+	drain();
+	code = dmxrx_packet();
+	check(code == 0xCC, "packet: not reported");
+	ok = 1;
+	for(k=1;k<=24;k++)
+		ok &= (dmxrx_getc() == k + 0x40);
+	check(ok && dmxrx_ok(), "packet: bytes wrong");
+	dmxrx_end();
+	check(dmxrx_packet() < 0, "packet: reported twice");
+
+	// Cut short by the next Break
+	packet(0xCC, 5, 0);
+	packet(0x00, 512, 0);
+	drain();
+	check(dmxrx_packet() == 0xCC, "cut packet: not reported");
+	for(k=1;k<=10;k++)
+		dmxrx_getc();
+	check(!dmxrx_ok(), "cut packet: taken as whole");
+	dmxrx_end();
+
+	// Main loop away for a packet longer than the ring
+	packet(0xCC, 100, 0);
+	drain();
+	check(dmxrx_ring()->drops == 100-63 && dmxrx_ring()->highWater == 63, "slow reader: drops not counted");
+	code = dmxrx_packet();
+	check(code == 0xCC && dmxrx_getc() == 1 && !dmxrx_ok(), "slow reader: packet taken as whole");
+	dmxrx_end();
+	packet(0xCC, 24, 0x40);
+	drain();
+	code = dmxrx_packet();
+	ok = 1;
+	for(k=1;k<=24;k++)
+		ok &= (dmxrx_getc() == k + 0x40);
+	check(code == 0xCC && ok && dmxrx_ok(), "slow reader: next packet wrong");
+	dmxrx_end();
+	printf("slow reader  %u of 100 bytes dropped, %u queued at most\n", dmxrx_ring()->drops, dmxrx_ring()->highWater);
+
+	// Receiver locked out long enough to lose bytes
+	n = dmxrx_errors();
+	SRbits.IPL = 7;
+	packet(0xCC, 10, 0);
+	sim_run(12*SLOT_US);
+	SRbits.IPL = 0;
+	drain();
+	check(dmxrx_errors() == n+1, "overrun: not counted");
+	code = dmxrx_packet();
+	check(code < 0 || !dmxrx_ok(), "overrun: packet taken as whole");
+	dmxrx_end();
+
+	// Still in step after all that
+	dmxrx_window(100, 4);
+	n = frames;
+	packet(0x00, 512, 9);
+	drain();
+	check(frames == n+1 && seen[0] == ((100 + 9) & 0xFF), "after errors: window lost");
+
+	printf(errors ? "FAILED\n" : "OK\n");
+	return errors != 0;
+}
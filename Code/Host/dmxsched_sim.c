@@ -0,0 +1,149 @@
+/*! \file dmxsched_sim.c \brief Runs the DMX frame scheduler against the host model. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'dmxsched_sim.c'
+// Title		: DMX frame scheduler on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// Runs the scheduler for a few seconds in each set up and measures the
+// Break to Break time on the wire. Checks the achieved rate, the MBB and the
+// E1.11 minimum Break to Break time. Then frames are held back for a 3 ms
+// gap (a POLL probe): nothing may start meanwhile, and the held frame has to
+// start right at the release. Exit code is non zero on a mismatch.
+//*****************************************************************************
+
+#include <p33FJ128MC802.h>
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "dmxtx.h"
+#include "dmxsched.h"
+
+
+#define BAUD_250K 9
+#define RUN_US 2000000UL
+#define GAP_US 3000					// Bus time taken from the frames
+
+
+typedef struct
+{
+	unsigned int rate;				// Scheduler set up
+	unsigned int mbb;
+	unsigned int slots;
+	unsigned int minHz10, maxHz10;	// Expected rate window
+} CASE;
+
+
+int main()
+{
+	const CASE cases[] = {
+		{ 44,   0, 512,  435,  445},	// Full universe at 44 Hz
+		{  0,   0, 512,  435,  445},	// As fast as possible, 512 slots
+		{  0,   0,  24, 8150, 8310},	// Short universe, E1.11 minimum Break to Break
+		{  0,   0,   8, 8150, 8310},	// Shorter still, stretched to 1204 us
+		{  0, 500, 100, 1950, 1980},	// 500 us mark between frames
+		{200,   0, 100, 1990, 2010},	// 200 Hz
+	};
+	unsigned int c, i, n, errors = 0;
+	unsigned long b2b, minB2b, lastBrk, gapMin, since, release;
+	const SIM_WIRE *w;
+
+	for(c=0;c<sizeof(cases)/sizeof(cases[0]);c++)
+	{
+		sim_init();
+		U2BRG = BAUD_250K;
+		U2MODE = 0x8001;			// Same set up as uart2_init()
+		U2STA = 0x0400;
+		dmxsched_init();
+		sim_run(1);
+
+		memset(dmxtx_getBuf(), 0, 513);
+		dmxtx_mark(0, 512);
+		dmxtx_commit(cases[c].slots);
+		dmxsched_setRate(cases[c].rate);
+		dmxsched_setMbb(cases[c].mbb);
+		dmxsched_start();
+		sim_run(RUN_US);
+		dmxsched_stop();
+		while(dmxtx_busy())			// Let the last frame out before the next set up
+			sim_run(1);
+
+		w = sim_wire();
+		n = sim_wireCount();
+		minB2b = ~0UL;
+		gapMin = ~0UL;
+		lastBrk = 0;
+		for(i=0;i<n;i++)
+		{
+			if(w[i].data != SIM_BREAK)
+				continue;
+			if(lastBrk)
+			{
+				b2b = (w[i].us - w[i].brkUs) - lastBrk;
+				if(b2b < minB2b)
+					minB2b = b2b;
+				if(w[i].us - w[i].brkUs - w[i-1].us < gapMin)	// Last stop bit to Break
+					gapMin = w[i].us - w[i].brkUs - w[i-1].us;
+			}
+			lastBrk = w[i].us - w[i].brkUs;
+		}
+
+		printf("rate %3u Hz, mbb %3u us, %3u slots: achieved %3u.%u Hz, jitter %3u us, "
+				"Break to Break >= %4lu us, mark >= %3lu us\n",
+				cases[c].rate, cases[c].mbb, cases[c].slots, dmxsched_rate10()/10,
+				dmxsched_rate10()%10, dmxsched_jitterUs(), minB2b, gapMin);
+
+		if(dmxsched_rate10() < cases[c].minHz10 || dmxsched_rate10() > cases[c].maxHz10)
+		{
+			printf("  rate out of range\n");
+			errors++;
+		}
+		if(minB2b < B2B_MIN_US || gapMin < cases[c].mbb)
+		{
+			printf("  timing below minimum\n");
+			errors++;
+		}
+	}
+
+	sim_init();						// Back to back frames, held for a gap
+	U2BRG = BAUD_250K;
+	U2MODE = 0x8001;
+	U2STA = 0x0400;
+	dmxsched_init();
+	sim_run(1);
+	dmxtx_commit(100);
+	dmxsched_setRate(0);
+	dmxsched_setMbb(0);
+	dmxsched_start();
+	sim_run(10000);
+	dmxsched_hold();
+	while(dmxtx_busy())
+		sim_run(1);
+	since = dmxsched_sinceBrkUs();	// Frame just ended: Break, MAB and 101 slots
+	sim_wireClear();
+	sim_run(GAP_US);
+	n = sim_wireCount();
+	release = sim_now();
+	dmxsched_release();
+	while(sim_wireCount() == 0)
+		sim_run(1);
+	w = sim_wire();
+	printf("hold: frame %lu us before the gap, Break %lu us after the release\n",
+			since, w[0].us - w[0].brkUs - release);
+	if(n != 0 || w[0].data != SIM_BREAK || w[0].us - w[0].brkUs - release > 2
+			|| since < 116+101*44 || since > 116+102*44)
+	{
+		printf("  frame held wrong\n");
+		errors++;
+	}
+	dmxsched_stop();
+
+	printf(errors ? "FAILED\n" : "OK\n");
+	return errors != 0;
+}
@@ -0,0 +1,156 @@
+/*! \file dmxtx_sim.c \brief Runs the DMX frame transmitter against the host model. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'dmxtx_sim.c'
+// Title		: DMX frame transmitter on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// Sends a few frames through 'dmxtx.c' and checks what comes out of the
+// UART: Break and MAB length, start code and every slot. While a frame is
+// on the wire the staging buffer is scribbled over, which must not show up on
+// the wire. Then three slots are changed one by one across frames; they must
+// only show up together, after the commit. Exit code is non zero on a
+// mismatch.
+//*****************************************************************************
+
+#include <p33FJ128MC802.h>
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "dmxtx.h"
+#include "dmxbrk.h"
+
+
+#define BAUD_250K 9
+#define FRAMES 4
+#define RGB_SLOTS 24
+
+
+// Send one frame and wait till it is out
+static void frame(void)
+{
+	sim_wireClear();
+	dmxtx_start(0);
+	while(dmxtx_busy())
+		sim_run(1);
+}
+
+
+// Slots 1 to 3 on the wire as 0xRRGGBB
+static unsigned long wireRgb(void)
+{
+	const SIM_WIRE *w = sim_wire();
+
+	return ((unsigned long)w[2].data << 16) | (w[3].data << 8) | w[4].data;
+}
+
+
+int main()
+{
+	unsigned int slots[FRAMES] = {512, 24, 100, 24};
+	unsigned int brk[FRAMES] = {BRK_DEF_US, BRK_DEF_US, 200, BRK_MIN_US};
+	unsigned int mab[FRAMES] = {MAB_DEF_US, MAB_DEF_US, 40, MAB_MIN_US};
+	unsigned int i, f, errors = 0;
+	unsigned long start, busyUs;
+	unsigned char *buf;
+	const SIM_WIRE *w;
+
+	sim_init();
+	U2BRG = BAUD_250K;
+	U2MODE = 0x8001;				// Same set up as uart2_init()
+	U2STA = 0x0400;
+	dmxtx_init(0);
+	sim_run(1);						// Let the status bits settle
+
+	for(f=0;f<FRAMES;f++)
+	{
+		dmxbrk_set(brk[f], mab[f]);
+		buf = dmxtx_getBuf();		// Prepare frame 'f'
+		buf[0] = 0;					// Start code
+		for(i=1;i<513;i++)
+			buf[i] = (i + f*7) & 0xFF;
+		dmxtx_mark(0, 512);
+
+		dmxtx_commit(slots[f]);
+
+		sim_wireClear();
+		start = sim_now();
+		dmxtx_start(0);
+
+		memset(dmxtx_getBuf(), 0xAA, 513);	// Next frame is being prepared meanwhile
+		dmxtx_mark(0, 512);
+
+		while(dmxtx_busy())
+			sim_run(1);
+		busyUs = sim_now() - start;
+
+		w = sim_wire();
+		if(sim_wireCount() != slots[f]+2 || w[0].data != SIM_BREAK || w[1].data != 0)
+		{
+			printf("frame %u: %u bytes on the wire, expected %u\n", f, sim_wireCount(), slots[f]+2);
+			errors++;
+			continue;
+		}
+		if(w[0].brkUs < brk[f] || w[0].brkUs > brk[f]+2 || w[0].mabUs < mab[f] || w[0].mabUs > mab[f]+2)
+		{
+			printf("frame %u: Break %u us, MAB %u us\n", f, w[0].brkUs, w[0].mabUs);
+			errors++;
+		}
+		for(i=1;i<=slots[f];i++)
+		{
+			if(w[i+1].data != ((i + f*7) & 0xFF))
+			{
+				printf("frame %u: slot %u is %u\n", f, i, w[i+1].data);
+				errors++;
+				break;
+			}
+		}
+		printf("frame %u: %3u slots, Break %3u us, MAB %2u us, Break to last stop bit %5lu us\n",
+				f, slots[f], w[0].brkUs, w[0].mabUs, busyUs);
+	}
+
+	dmxbrk_set(BRK_DEF_US, MAB_DEF_US);	// Colour change, one slot per frame
+	buf = dmxtx_getBuf();
+	memset(buf, 0, 513);
+	dmxtx_mark(0, 512);
+	dmxtx_commit(RGB_SLOTS);
+	frame();
+	for(i=1;i<=3;i++)
+	{
+		dmxtx_getBuf()[i] = 0xFF;
+		dmxtx_mark(i, i);
+		frame();
+		if(wireRgb() != 0)
+		{
+			printf("colour: uncommitted slot %u on the wire\n", i);
+			errors++;
+		}
+	}
+	dmxtx_commit(RGB_SLOTS);
+	dmxtx_getBuf()[4] = 0x11;			// Staging must have caught up with slots 1 to 3
+	dmxtx_mark(4, 4);
+	dmxtx_commit(RGB_SLOTS);			// Replaces the frame not sent yet
+	frame();
+	if(wireRgb() != 0xFFFFFFUL || sim_wire()[5].data != 0x11)
+	{
+		printf("colour: %06lx %02x after commit\n", wireRgb(), sim_wire()[5].data);
+		errors++;
+	}
+	else
+		printf("colour: slots 1 to 3 changed in one frame\n");
+
+	if(dmxbrk_set(BRK_MIN_US-1, MAB_MIN_US) || dmxbrk_set(BRK_MIN_US, MAB_MIN_US-1))
+	{
+		printf("Break/MAB below E1.11 minimum accepted\n");
+		errors++;
+	}
+
+	printf(errors ? "FAILED\n" : "OK\n");
+	return errors != 0;
+}
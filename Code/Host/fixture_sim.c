@@ -0,0 +1,121 @@
+/*! \file fixture_sim.c \brief Runs the Device personalities on the host. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'fixture_sim.c'
+// Title		: Fixture personalities on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// Hands one frame to every personality of 'fixture.c' and checks the levels
+// it gives pwm.c (stood in for here): each output must follow its own slot
+// (or coarse/fine pair), outputs a personality doesn't use must be off, a
+// footprint cut short by the end of the frame must read as 0, 255 (or
+// 0xFFFF) must be full on, and every frame must end with one pwm_frame().
+// Exit code is non zero on a mismatch.
+//*****************************************************************************
+
+#include <stdio.h>
+#include "fixture.h"
+#include "pwm.h"
+
+
+// Outputs expected per personality: coarse slot, fine slot (-1: 8 bit), -1/-1 off
+static const int expect[FIX_COUNT][PWM_OUTPUTS][2] = {
+	{{0, -1},	{-1, -1},	{-1, -1},	{-1, -1}},
+	{{0, -1},	{1, -1},	{2, -1},	{-1, -1}},
+	{{0, -1},	{1, -1},	{2, -1},	{3, -1}},
+	{{0, 1},	{-1, -1},	{-1, -1},	{-1, -1}},
+	{{0, 1},	{2, 3},		{4, 5},		{-1, -1}},
+	{{0, 1},	{2, 3},		{4, 5},		{6, 7}},
+};
+
+unsigned int lvl[PWM_OUTPUTS];		// Levels set
+unsigned int frames;				// pwm_frame() calls
+
+
+// pwm.c for this test
+void pwm_set(unsigned int out, unsigned int level)
+{
+	if(out < PWM_OUTPUTS)
+		lvl[out] = level;
+}
+
+
+void pwm_frame(void)
+{
+	frames++;
+}
+
+
+int main()
+{
+	unsigned char slots[FIX_FOOTPRINT_MAX] = {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xFF};
+	unsigned char full[FIX_FOOTPRINT_MAX] = {255, 255, 255, 255, 255, 255, 255, 255};
+	unsigned int got[PWM_OUTPUTS];
+	unsigned int p, i, n, level, errors = 0;
+	int c, f;
+
+	for(p=0;p<FIX_COUNT;p++)
+	{
+		for(i=0;i<PWM_OUTPUTS;i++)	// Left over from the last one
+			lvl[i] = 0x5555;
+		if(!fixture_select(p) || fixture_personality() != p)
+		{
+			printf("%s: can't select it\n", fixture_name(p));
+			errors++;
+			continue;
+		}
+		n = fixture_footprint();
+		frames = 0;
+		fixture_frame(slots, n);
+		if(frames != 1)
+		{
+			printf("%s: %u pwm_frame() calls for a frame\n", fixture_name(p), frames);
+			errors++;
+		}
+		for(i=0;i<PWM_OUTPUTS;i++)
+		{
+			c = expect[p][i][0];
+			f = expect[p][i][1];
+			if(c < 0)
+				level = 0;
+			else
+				level = (slots[c] << 8) | (f < 0 ? slots[c] : slots[f]);
+			got[i] = lvl[i];
+			if(lvl[i] != level)
+			{
+				printf("%s: OC%u level %u, expected %u\n", fixture_name(p), i+1, lvl[i], level);
+				errors++;
+			}
+		}
+
+		fixture_frame(slots, 1);	// Frame ends after the first slot
+		for(i=1;i<PWM_OUTPUTS;i++)
+			if(expect[p][i][0] >= 0 && lvl[i] != 0)
+			{
+				printf("%s: OC%u on past the end of the frame\n", fixture_name(p), i+1);
+				errors++;
+			}
+
+		fixture_frame(full, n);
+		if(lvl[0] != 0xFFFF)
+		{
+			printf("%s: full is %u, not %u\n", fixture_name(p), lvl[0], 0xFFFF);
+			errors++;
+		}
+		printf("%-14s %u slots, OC1..OC4 %5u %5u %5u %5u\n", fixture_name(p), n, got[0], got[1], got[2], got[3]);
+	}
+	if(fixture_select(FIX_COUNT))
+	{
+		printf("Personality %u taken\n", FIX_COUNT);
+		errors++;
+	}
+
+	printf(errors ? "FAILED\n" : "OK\n");
+	return errors != 0;
+}
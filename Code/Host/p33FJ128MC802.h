@@ -0,0 +1,652 @@
+/*! \file p33FJ128MC802.h \brief Host image of the dsPIC33FJ128MC802 registers. */
+//*****************************************************************************
+//
+// File Name	: 'p33FJ128MC802.h'
+// Title		: Register image for the host build
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// Stands in for the Microchip header when the firmware is compiled on a PC.
+// Every SFR the firmware touches is a plain variable with the same name and
+// bit layout as on the chip. 'sim.c' plays the peripherals behind them.
+// Only the registers in use are here; add more as the firmware needs them.
+//
+// The UART Tx registers and the receive buffers are functions: a write to
+// UxTXREG goes into the Tx FIFO at once, a read of UxRXREG pops the FIFO.
+//*****************************************************************************
+
+#ifndef __P33FJ128MC802_HOST_H__
+ #define __P33FJ128MC802_HOST_H__
+
+#define SIM_HOST					// Firmware is built for the host ('hal.h')
+
+
+// dsPIC only attributes and builtins
+#define interrupt
+#define no_auto_psv
+#define space(x)
+#define __builtin_dmaoffset(p)	sim_dmaOffset(p)
+
+unsigned int sim_dmaOffset(const void *p);
+void sim_spin(void);
+void sim_idle(void);
+
+#define Idle()		sim_idle()		// Sleeps up to the next interrupt
+#define Nop()
+
+// MPLAB C30 library
+char *itoa(char *buf, int val, int base);
+
+
+// A register with a bit field view.  'REG' is the word, 'REGbits' the fields.
+#define HOST_SFR(reg) \
+	typedef union { unsigned int w; reg##BITS bits; } reg##SFR; \
+	extern volatile reg##SFR sfr##reg;
+
+
+//-----------------------------------------------------------------------------
+// CPU status (only the interrupt priority level)
+//-----------------------------------------------------------------------------
+typedef struct tagSRBITS {
+	unsigned C:1;
+	unsigned Z:1;
+	unsigned OV:1;
+	unsigned N:1;
+	unsigned RA:1;
+	unsigned IPL:3;
+	unsigned DC:1;
+	unsigned :7;
+} SRBITS;
+HOST_SFR(SR)
+#define SR			sfrSR.w
+#define SRbits		sfrSR.bits
+
+// Same use as the Microchip macros; no DISI needed on the host
+#define SET_CPU_IPL(ipl)					SRbits.IPL = (ipl)
+#define SET_AND_SAVE_CPU_IPL(save_to, ipl)	{ save_to = SRbits.IPL; SET_CPU_IPL(ipl); }
+#define RESTORE_CPU_IPL(saved_to)			SET_CPU_IPL(saved_to)
+
+
+//-----------------------------------------------------------------------------
+// Interrupt flags and enables
+//-----------------------------------------------------------------------------
+typedef struct tagIFS0BITS {
+	unsigned INT0IF:1;
+	unsigned IC1IF:1;
+	unsigned OC1IF:1;
+	unsigned T1IF:1;
+	unsigned DMA0IF:1;
+	unsigned IC2IF:1;
+	unsigned OC2IF:1;
+	unsigned T2IF:1;
+	unsigned T3IF:1;
+	unsigned SPI1EIF:1;
+	unsigned SPI1IF:1;
+	unsigned U1RXIF:1;
+	unsigned U1TXIF:1;
+	unsigned AD1IF:1;
+	unsigned DMA1IF:1;
+	unsigned :1;
+} IFS0BITS;
+HOST_SFR(IFS0)
+#define IFS0		sfrIFS0.w
+#define IFS0bits	sfrIFS0.bits
+
+typedef struct tagIEC0BITS {
+	unsigned INT0IE:1;
+	unsigned IC1IE:1;
+	unsigned OC1IE:1;
+	unsigned T1IE:1;
+	unsigned DMA0IE:1;
+	unsigned IC2IE:1;
+	unsigned OC2IE:1;
+	unsigned T2IE:1;
+	unsigned T3IE:1;
+	unsigned SPI1EIE:1;
+	unsigned SPI1IE:1;
+	unsigned U1RXIE:1;
+	unsigned U1TXIE:1;
+	unsigned AD1IE:1;
+	unsigned DMA1IE:1;
+	unsigned :1;
+} IEC0BITS;
+HOST_SFR(IEC0)
+#define IEC0		sfrIEC0.w
+#define IEC0bits	sfrIEC0.bits
+
+typedef struct tagIFS1BITS {
+	unsigned SI2C1IF:1;
+	unsigned MI2C1IF:1;
+	unsigned CMIF:1;
+	unsigned CNIF:1;
+	unsigned INT1IF:1;
+	unsigned :1;
+	unsigned IC7IF:1;
+	unsigned IC8IF:1;
+	unsigned DMA2IF:1;
+	unsigned OC3IF:1;
+	unsigned OC4IF:1;
+	unsigned T4IF:1;
+	unsigned T5IF:1;
+	unsigned INT2IF:1;
+	unsigned U2RXIF:1;
+	unsigned U2TXIF:1;
+} IFS1BITS;
+HOST_SFR(IFS1)
+#define IFS1		sfrIFS1.w
+#define IFS1bits	sfrIFS1.bits
+
+typedef struct tagIEC1BITS {
+	unsigned SI2C1IE:1;
+	unsigned MI2C1IE:1;
+	unsigned CMIE:1;
+	unsigned CNIE:1;
+	unsigned INT1IE:1;
+	unsigned :1;
+	unsigned IC7IE:1;
+	unsigned IC8IE:1;
+	unsigned DMA2IE:1;
+	unsigned OC3IE:1;
+	unsigned OC4IE:1;
+	unsigned T4IE:1;
+	unsigned T5IE:1;
+	unsigned INT2IE:1;
+	unsigned U2RXIE:1;
+	unsigned U2TXIE:1;
+} IEC1BITS;
+HOST_SFR(IEC1)
+#define IEC1		sfrIEC1.w
+#define IEC1bits	sfrIEC1.bits
+
+
+//-----------------------------------------------------------------------------
+// Oscillator (the model always runs at FCY)
+//-----------------------------------------------------------------------------
+typedef struct tagPLLFBDBITS {
+	unsigned PLLDIV:9;
+	unsigned :7;
+} PLLFBDBITS;
+HOST_SFR(PLLFBD)
+#define PLLFBD		sfrPLLFBD.w
+#define PLLFBDbits	sfrPLLFBD.bits
+
+typedef struct tagCLKDIVBITS {
+	unsigned PLLPRE:5;
+	unsigned :1;
+	unsigned PLLPOST:2;
+	unsigned FRCDIV:3;
+	unsigned DOZEN:1;
+	unsigned DOZE:3;
+	unsigned ROI:1;
+} CLKDIVBITS;
+HOST_SFR(CLKDIV)
+#define CLKDIV		sfrCLKDIV.w
+#define CLKDIVbits	sfrCLKDIV.bits
+
+
+//-----------------------------------------------------------------------------
+// Port A, analog pins and Change Notification
+//-----------------------------------------------------------------------------
+typedef struct tagTRISABITS {
+	unsigned TRISA0:1;
+	unsigned TRISA1:1;
+	unsigned TRISA2:1;
+	unsigned TRISA3:1;
+	unsigned TRISA4:1;
+	unsigned :11;
+} TRISABITS;
+HOST_SFR(TRISA)
+#define TRISA		sfrTRISA.w
+#define TRISAbits	sfrTRISA.bits
+
+typedef struct tagPORTABITS {
+	unsigned RA0:1;
+	unsigned RA1:1;
+	unsigned RA2:1;
+	unsigned RA3:1;
+	unsigned RA4:1;
+	unsigned :11;
+} PORTABITS;
+HOST_SFR(PORTA)
+#define PORTA		sfrPORTA.w
+#define PORTAbits	sfrPORTA.bits
+
+typedef struct tagAD1PCFGLBITS {
+	unsigned PCFG0:1;
+	unsigned PCFG1:1;
+	unsigned PCFG2:1;
+	unsigned PCFG3:1;
+	unsigned PCFG4:1;
+	unsigned PCFG5:1;
+	unsigned :10;
+} AD1PCFGLBITS;
+HOST_SFR(AD1PCFGL)
+#define AD1PCFGL	sfrAD1PCFGL.w
+#define AD1PCFGLbits	sfrAD1PCFGL.bits
+
+typedef struct tagCNPU1BITS {
+	unsigned CN0PUE:1;
+	unsigned CN1PUE:1;
+	unsigned CN2PUE:1;
+	unsigned CN3PUE:1;
+	unsigned CN4PUE:1;
+	unsigned CN5PUE:1;
+	unsigned CN6PUE:1;
+	unsigned CN7PUE:1;
+	unsigned CN8PUE:1;
+	unsigned CN9PUE:1;
+	unsigned CN10PUE:1;
+	unsigned CN11PUE:1;
+	unsigned CN12PUE:1;
+	unsigned CN13PUE:1;
+	unsigned CN14PUE:1;
+	unsigned CN15PUE:1;
+} CNPU1BITS;
+HOST_SFR(CNPU1)
+#define CNPU1		sfrCNPU1.w
+#define CNPU1bits	sfrCNPU1.bits
+
+typedef struct tagCNPU2BITS {
+	unsigned CN16PUE:1;
+	unsigned CN17PUE:1;
+	unsigned CN18PUE:1;
+	unsigned CN19PUE:1;
+	unsigned CN20PUE:1;
+	unsigned CN21PUE:1;
+	unsigned CN22PUE:1;
+	unsigned CN23PUE:1;
+	unsigned CN24PUE:1;
+	unsigned CN25PUE:1;
+	unsigned CN26PUE:1;
+	unsigned CN27PUE:1;
+	unsigned CN28PUE:1;
+	unsigned CN29PUE:1;
+	unsigned CN30PUE:1;
+	unsigned :1;
+} CNPU2BITS;
+HOST_SFR(CNPU2)
+#define CNPU2		sfrCNPU2.w
+#define CNPU2bits	sfrCNPU2.bits
+
+typedef struct tagCNEN1BITS {
+	unsigned CN0IE:1;
+	unsigned CN1IE:1;
+	unsigned CN2IE:1;
+	unsigned CN3IE:1;
+	unsigned CN4IE:1;
+	unsigned CN5IE:1;
+	unsigned CN6IE:1;
+	unsigned CN7IE:1;
+	unsigned CN8IE:1;
+	unsigned CN9IE:1;
+	unsigned CN10IE:1;
+	unsigned CN11IE:1;
+	unsigned CN12IE:1;
+	unsigned CN13IE:1;
+	unsigned CN14IE:1;
+	unsigned CN15IE:1;
+} CNEN1BITS;
+HOST_SFR(CNEN1)
+#define CNEN1		sfrCNEN1.w
+#define CNEN1bits	sfrCNEN1.bits
+
+typedef struct tagCNEN2BITS {
+	unsigned CN16IE:1;
+	unsigned CN17IE:1;
+	unsigned CN18IE:1;
+	unsigned CN19IE:1;
+	unsigned CN20IE:1;
+	unsigned CN21IE:1;
+	unsigned CN22IE:1;
+	unsigned CN23IE:1;
+	unsigned CN24IE:1;
+	unsigned CN25IE:1;
+	unsigned CN26IE:1;
+	unsigned CN27IE:1;
+	unsigned CN28IE:1;
+	unsigned CN29IE:1;
+	unsigned CN30IE:1;
+	unsigned :1;
+} CNEN2BITS;
+HOST_SFR(CNEN2)
+#define CNEN2		sfrCNEN2.w
+#define CNEN2bits	sfrCNEN2.bits
+
+
+//-----------------------------------------------------------------------------
+// Port B and Peripheral Pin Select
+//-----------------------------------------------------------------------------
+typedef struct tagLATBBITS {
+	unsigned LATB0:1;
+	unsigned LATB1:1;
+	unsigned LATB2:1;
+	unsigned LATB3:1;
+	unsigned LATB4:1;
+	unsigned LATB5:1;
+	unsigned LATB6:1;
+	unsigned LATB7:1;
+	unsigned LATB8:1;
+	unsigned LATB9:1;
+	unsigned LATB10:1;
+	unsigned LATB11:1;
+	unsigned LATB12:1;
+	unsigned LATB13:1;
+	unsigned LATB14:1;
+	unsigned LATB15:1;
+} LATBBITS;
+HOST_SFR(LATB)
+#define LATB		sfrLATB.w
+#define LATBbits	sfrLATB.bits
+
+typedef struct tagTRISBBITS {
+	unsigned TRISB0:1;
+	unsigned TRISB1:1;
+	unsigned TRISB2:1;
+	unsigned TRISB3:1;
+	unsigned TRISB4:1;
+	unsigned TRISB5:1;
+	unsigned TRISB6:1;
+	unsigned TRISB7:1;
+	unsigned TRISB8:1;
+	unsigned TRISB9:1;
+	unsigned TRISB10:1;
+	unsigned TRISB11:1;
+	unsigned TRISB12:1;
+	unsigned TRISB13:1;
+	unsigned TRISB14:1;
+	unsigned TRISB15:1;
+} TRISBBITS;
+HOST_SFR(TRISB)
+#define TRISB		sfrTRISB.w
+#define TRISBbits	sfrTRISB.bits
+
+typedef struct tagPORTBBITS {
+	unsigned RB0:1;
+	unsigned RB1:1;
+	unsigned RB2:1;
+	unsigned RB3:1;
+	unsigned RB4:1;
+	unsigned RB5:1;
+	unsigned RB6:1;
+	unsigned RB7:1;
+	unsigned RB8:1;
+	unsigned RB9:1;
+	unsigned RB10:1;
+	unsigned RB11:1;
+	unsigned RB12:1;
+	unsigned RB13:1;
+	unsigned RB14:1;
+	unsigned RB15:1;
+} PORTBBITS;
+HOST_SFR(PORTB)
+#define PORTB		sfrPORTB.w
+#define PORTBbits	sfrPORTB.bits
+
+typedef struct tagRPOR0BITS {
+	unsigned RP0R:5;
+	unsigned :3;
+	unsigned RP1R:5;
+	unsigned :3;
+} RPOR0BITS;
+HOST_SFR(RPOR0)
+#define RPOR0		sfrRPOR0.w
+#define RPOR0bits	sfrRPOR0.bits
+
+typedef struct tagRPOR1BITS {
+	unsigned RP2R:5;
+	unsigned :3;
+	unsigned RP3R:5;
+	unsigned :3;
+} RPOR1BITS;
+HOST_SFR(RPOR1)
+#define RPOR1		sfrRPOR1.w
+#define RPOR1bits	sfrRPOR1.bits
+
+typedef struct tagRPOR3BITS {
+	unsigned RP6R:5;
+	unsigned :3;
+	unsigned RP7R:5;
+	unsigned :3;
+} RPOR3BITS;
+HOST_SFR(RPOR3)
+#define RPOR3		sfrRPOR3.w
+#define RPOR3bits	sfrRPOR3.bits
+
+typedef struct tagRPOR5BITS {
+	unsigned RP10R:5;
+	unsigned :3;
+	unsigned RP11R:5;
+	unsigned :3;
+} RPOR5BITS;
+HOST_SFR(RPOR5)
+#define RPOR5		sfrRPOR5.w
+#define RPOR5bits	sfrRPOR5.bits
+
+typedef struct tagRPINR7BITS {
+	unsigned IC1R:5;
+	unsigned :3;
+	unsigned IC2R:5;
+	unsigned :3;
+} RPINR7BITS;
+HOST_SFR(RPINR7)
+#define RPINR7		sfrRPINR7.w
+#define RPINR7bits	sfrRPINR7.bits
+
+typedef struct tagRPINR18BITS {
+	unsigned U1RXR:5;
+	unsigned :3;
+	unsigned U1CTSR:5;
+	unsigned :3;
+} RPINR18BITS;
+HOST_SFR(RPINR18)
+#define RPINR18		sfrRPINR18.w
+#define RPINR18bits	sfrRPINR18.bits
+
+typedef struct tagRPINR19BITS {
+	unsigned U2RXR:5;
+	unsigned :3;
+	unsigned U2CTSR:5;
+	unsigned :3;
+} RPINR19BITS;
+HOST_SFR(RPINR19)
+#define RPINR19		sfrRPINR19.w
+#define RPINR19bits	sfrRPINR19.bits
+
+
+//-----------------------------------------------------------------------------
+// Timer1 to Timer5
+//-----------------------------------------------------------------------------
+typedef struct tagTxCONBITS {
+	unsigned :1;
+	unsigned TCS:1;
+	unsigned :1;
+	unsigned T32:1;
+	unsigned TCKPS:2;
+	unsigned TGATE:1;
+	unsigned :6;
+	unsigned TSIDL:1;
+	unsigned :1;
+	unsigned TON:1;
+} TxCONBITS;
+typedef TxCONBITS T1CONBITS;				// T32 is TSYNC on Timer1
+typedef TxCONBITS T2CONBITS;
+typedef TxCONBITS T3CONBITS;
+typedef TxCONBITS T4CONBITS;
+typedef TxCONBITS T5CONBITS;
+HOST_SFR(T1CON)
+HOST_SFR(T2CON)
+HOST_SFR(T3CON)
+HOST_SFR(T4CON)
+HOST_SFR(T5CON)
+#define T1CON		sfrT1CON.w
+#define T1CONbits	sfrT1CON.bits
+#define T2CON		sfrT2CON.w
+#define T2CONbits	sfrT2CON.bits
+#define T3CON		sfrT3CON.w
+#define T3CONbits	sfrT3CON.bits
+#define T4CON		sfrT4CON.w
+#define T4CONbits	sfrT4CON.bits
+#define T5CON		sfrT5CON.w
+#define T5CONbits	sfrT5CON.bits
+
+extern volatile unsigned int TMR1, TMR2, TMR3, TMR4, TMR5;
+extern volatile unsigned int PR1, PR2, PR3, PR4, PR5;
+
+
+//-----------------------------------------------------------------------------
+// UART1 and UART2
+//-----------------------------------------------------------------------------
+typedef struct tagUxMODEBITS {
+	unsigned STSEL:1;
+	unsigned PDSEL:2;
+	unsigned BRGH:1;
+	unsigned URXINV:1;
+	unsigned ABAUD:1;
+	unsigned LPBACK:1;
+	unsigned WAKE:1;
+	unsigned UEN:2;
+	unsigned :1;
+	unsigned RTSMD:1;
+	unsigned IREN:1;
+	unsigned USIDL:1;
+	unsigned :1;
+	unsigned UARTEN:1;
+} UxMODEBITS;
+typedef UxMODEBITS U1MODEBITS;
+typedef UxMODEBITS U2MODEBITS;
+HOST_SFR(U1MODE)
+HOST_SFR(U2MODE)
+#define U1MODE		sfrU1MODE.w
+#define U1MODEbits	sfrU1MODE.bits
+#define U2MODE		sfrU2MODE.w
+#define U2MODEbits	sfrU2MODE.bits
+
+typedef struct tagUxSTABITS {
+	unsigned URXDA:1;
+	unsigned OERR:1;
+	unsigned FERR:1;
+	unsigned PERR:1;
+	unsigned RIDLE:1;
+	unsigned ADDEN:1;
+	unsigned URXISEL:2;
+	unsigned TRMT:1;
+	unsigned UTXBF:1;
+	unsigned UTXEN:1;
+	unsigned UTXBRK:1;
+	unsigned :1;
+	unsigned UTXISEL0:1;
+	unsigned UTXINV:1;
+	unsigned UTXISEL1:1;
+} UxSTABITS;
+typedef UxSTABITS U1STABITS;
+typedef UxSTABITS U2STABITS;
+HOST_SFR(U1STA)
+HOST_SFR(U2STA)
+#define U1STA		sfrU1STA.w
+#define U1STAbits	sfrU1STA.bits
+#define U2STA		sfrU2STA.w
+#define U2STAbits	sfrU2STA.bits
+
+extern volatile unsigned int U1BRG, U2BRG;
+
+#define U1TXREG		(*sim_u1txReg())	// Written byte goes into the Tx FIFO
+#define U2TXREG		(*sim_u2txReg())
+#define U1RXREG		sim_u1rxReg()		// Reading pops the receive FIFO
+#define U2RXREG		sim_u2rxReg()
+
+volatile unsigned int *sim_u1txReg(void);
+volatile unsigned int *sim_u2txReg(void);
+unsigned int sim_u1rxReg(void);
+unsigned int sim_u2rxReg(void);
+
+
+//-----------------------------------------------------------------------------
+// Input capture 1
+//-----------------------------------------------------------------------------
+typedef struct tagIC1CONBITS {
+	unsigned ICM:3;
+	unsigned ICBNE:1;
+	unsigned ICOV:1;
+	unsigned ICI:2;
+	unsigned ICTMR:1;
+	unsigned :5;
+	unsigned ICSIDL:1;
+	unsigned :2;
+} IC1CONBITS;
+HOST_SFR(IC1CON)
+#define IC1CON		sfrIC1CON.w
+#define IC1CONbits	sfrIC1CON.bits
+
+#define IC1BUF		sim_ic1Buf()		// Reading pops the capture FIFO
+
+unsigned int sim_ic1Buf(void);
+
+
+//-----------------------------------------------------------------------------
+// Output compare 1 to 4 (registers only, nothing is driven)
+//-----------------------------------------------------------------------------
+typedef struct tagOCxCONBITS {
+	unsigned OCM:3;
+	unsigned OCTSEL:1;
+	unsigned OCFLT:1;
+	unsigned :8;
+	unsigned OCSIDL:1;
+	unsigned :2;
+} OCxCONBITS;
+typedef OCxCONBITS OC1CONBITS;
+typedef OCxCONBITS OC2CONBITS;
+typedef OCxCONBITS OC3CONBITS;
+typedef OCxCONBITS OC4CONBITS;
+HOST_SFR(OC1CON)
+HOST_SFR(OC2CON)
+HOST_SFR(OC3CON)
+HOST_SFR(OC4CON)
+#define OC1CON		sfrOC1CON.w
+#define OC1CONbits	sfrOC1CON.bits
+#define OC2CON		sfrOC2CON.w
+#define OC2CONbits	sfrOC2CON.bits
+#define OC3CON		sfrOC3CON.w
+#define OC3CONbits	sfrOC3CON.bits
+#define OC4CON		sfrOC4CON.w
+#define OC4CONbits	sfrOC4CON.bits
+
+extern volatile unsigned int OC1R, OC2R, OC3R, OC4R;
+extern volatile unsigned int OC1RS, OC2RS, OC3RS, OC4RS;
+
+
+//-----------------------------------------------------------------------------
+// DMA channel 0
+//-----------------------------------------------------------------------------
+typedef struct tagDMA0CONBITS {
+	unsigned MODE:2;
+	unsigned :2;
+	unsigned AMODE:2;
+	unsigned :5;
+	unsigned NULLW:1;
+	unsigned HALF:1;
+	unsigned DIR:1;
+	unsigned SIZE:1;
+	unsigned CHEN:1;
+} DMA0CONBITS;
+HOST_SFR(DMA0CON)
+#define DMA0CON		sfrDMA0CON.w
+#define DMA0CONbits	sfrDMA0CON.bits
+
+typedef struct tagDMA0REQBITS {
+	unsigned IRQSEL:7;
+	unsigned :8;
+	unsigned FORCE:1;
+} DMA0REQBITS;
+HOST_SFR(DMA0REQ)
+#define DMA0REQ		sfrDMA0REQ.w
+#define DMA0REQbits	sfrDMA0REQ.bits
+
+extern volatile unsigned int DMA0STA;
+extern volatile unsigned int DMA0STB;
+extern volatile unsigned int DMA0PAD;
+extern volatile unsigned int DMA0CNT;
+
+#endif
@@ -0,0 +1,158 @@
+/*! \file pwm_sim.c \brief Runs the Device PWM engine on the host. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'pwm_sim.c'
+// Title		: PWM engine on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// Runs 'pwm.c' on the Timer2 model and checks:
+// - the PWM period (PWM_HZ) and the dimmer curve (0 off, 0xFFFF on all
+//   the time, never going down as the level goes up)
+// - dithering: over 16 periods the duty cycle must average out to the
+//   16 bit level
+// - fading: with frames 22.7 ms apart (44 Hz) an output must move a
+//   little every period, be half way at half time and never overshoot
+// - a frame after a long pause fades in no more than PWM_FADE_MAX periods
+// Exit code is non zero on a mismatch.
+//*****************************************************************************
+
+#include <p33FJ128MC802.h>
+#include <stdio.h>
+#include "sim.h"
+#include "pwm.h"
+
+
+#define FRAME_US 22700				// 44 frames per second
+#define PERIOD_US (1000000UL/PWM_HZ)
+
+int errors = 0;
+
+
+static void check(int ok, const char *what)
+{
+	if(!ok)
+	{
+		printf("%s\n", what);
+		errors++;
+	}
+}
+
+
+// Level pwm_set() ends up with, once faded
+static unsigned int settle(unsigned int level)
+{
+	pwm_set(0, level);
+	pwm_frame();
+	sim_run((PWM_FADE_MAX+2)*PERIOD_US);
+	return pwm_get(0);
+}
+
+
+// Wait for the next PWM period to start
+static void period(void)
+{
+	unsigned int t = TMR2;
+
+	while(TMR2 >= t)
+	{
+		t = TMR2;
+		sim_run(1);
+	}
+}
+
+
+int main()
+{
+	unsigned int i, k, v, last, sum, steps, moves, maxMove;
+	unsigned long t0;
+
+	sim_init();
+	pwm_init();
+
+	// Period
+	check(PR2 == (1 << PWM_BITS) - 1, "period: PR2 wrong");
+	period();
+	t0 = sim_now();
+	for(i=0;i<100;i++)
+		period();
+	v = (sim_now() - t0) * 10;		// 1000 periods in us
+	printf("period       %u.%02u us, %lu Hz\n", v/1000, v%1000/10, PWM_HZ);
+	check(v >= 102000 && v <= 103000, "period: not 102.4 us");
+
+	// Curve
+	check(settle(0) == 0 && OC1RS == 0, "curve: 0 isn't off");
+	check(settle(0xFFFF) == 0xFFFF && OC1RS == PR2+1, "curve: 0xFFFF isn't on all the time");
+	last = 0;
+	for(k=0;k<=0xFFFF;k+=0x400)
+	{
+		pwm_set(0, k);
+		pwm_frame();
+		sim_run((PWM_FADE_MAX+2)*PERIOD_US);
+		check(pwm_get(0) >= last, "curve: goes down");
+		last = pwm_get(0);
+	}
+	printf("curve        half level %u of 65535\n", settle(0x8000));
+
+	// Dither: 16 periods average to the level
+	for(k=0;k<16;k++)
+	{
+		v = settle(0x1230 + k*0x111);
+		sum = 0;
+		for(i=0;i<16;i++)
+		{
+			period();
+			sim_run(2);
+			sum += OC1RS;
+		}
+		check(sum == (v >> 4)*16 + (v & 0xF), "dither: average off");
+	}
+	printf("dither       16 periods average to the 16 bit level\n");
+
+	// Fade between 44 Hz frames
+	settle(0);
+	for(i=0;i<3;i++)				// Frame rate is learnt from these
+	{
+		pwm_set(0, 0);
+		pwm_frame();
+		sim_run(FRAME_US);
+	}
+	pwm_set(0, 0xFFFF);
+	pwm_frame();
+	last = pwm_get(0);
+	steps = moves = maxMove = 0;
+	for(t0=0;t0<FRAME_US;t0+=PERIOD_US)
+	{
+		period();
+		sim_run(2);
+		v = pwm_get(0);
+		check(v >= last, "fade: goes back");
+		if(v != last)
+			moves++;
+		if(v - last > maxMove)
+			maxMove = v - last;
+		if(t0 < FRAME_US/2 && t0 + PERIOD_US >= FRAME_US/2)
+			check(v > 0x7000 && v < 0x9000, "fade: not half way at half time");
+		last = v;
+		steps++;
+	}
+	sim_run(2*PERIOD_US);
+	check(pwm_get(0) == 0xFFFF, "fade: target not reached");
+	printf("fade         %u of %u periods move, largest step %u\n", moves, steps, maxMove);
+	check(moves > steps*9/10 && maxMove < 0x200, "fade: steps too coarse");
+
+	// Pause, then a frame
+	sim_run(1000000);
+	pwm_set(0, 0);
+	pwm_frame();
+	sim_run((PWM_FADE_MAX+2)*PERIOD_US);
+	check(pwm_get(0) == 0, "pause: fade too long");
+
+	printf(errors ? "FAILED\n" : "OK\n");
+	return errors != 0;
+}
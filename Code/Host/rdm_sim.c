@@ -0,0 +1,240 @@
+/*! \file rdm_sim.c \brief Runs the RDM controller against RDM responders on the host. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'rdm_sim.c'
+// Title		: RDM on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// 'rdmctl.c' (Controller) talks to a model bus of 'rdmresp.c' responders
+// (Device firmware). Every responder sees every request; if several
+// answer, the bus carries the AND of their bytes (a low driver wins). A
+// request takes its bytes at 250 kbit/s, the answer the E1.20 turnaround
+// plus its bytes, silence the 2.8 ms the Controller waits.
+//
+// Rigs of 0 to 40 responders, with UIDs next to each other and spread out,
+// must be discovered exactly (beyond RDMCTL_DEVS only counted). Then GET
+// DEVICE_INFO, SET DMX_START_ADDRESS, IDENTIFY_DEVICE, a broadcast, an
+// unknown PID, a missing Device and a spoilt checksum are checked. Exit code
+// is non zero on a mismatch.
+//*****************************************************************************
+
+#include <p33FJ128MC802.h>
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "rdmctl.h"
+#include "rdmresp.h"
+#include "timebase.h"
+
+
+#define SLOT_US 44					// One slot at 250 kbit/s
+#define BRK_MAB_US (96+20)
+#define TURN_US 180					// Responder turnaround
+#define WAIT_US 2800				// Controller gives up
+#define RESP_MAX 40
+#define RIGS 6
+
+
+RDM_RESP resp[RESP_MAX];
+int respCount;
+unsigned int answers;				// Responders which answered the last request
+
+const unsigned char myUid[RDM_UID_LEN] = {0x7F, 0xF0, 0x80, 0, 0, 0};
+const unsigned char allUid[RDM_UID_LEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+
+// Model bus for rdmctl_init()
+static unsigned int bus(const unsigned char req[], unsigned int len, unsigned char out[])
+{
+	unsigned char answer[RDM_PKT_MAX];
+	unsigned int i, n, most = 0;
+	int k, brk, brkAnswer = 1;
+
+	sim_run(BRK_MAB_US + len*SLOT_US);
+	answers = 0;
+	for(k=0;k<respCount;k++)
+	{
+		n = rdmresp_handle(&resp[k], req, len, answer, &brk);
+		if(!n)
+			continue;
+		for(i=0;i<n;i++)
+			out[i] = answers ? out[i] & answer[i] : answer[i];
+		if(n > most)
+			most = n;
+		brkAnswer = brk;
+		answers++;
+	}
+	if(!most)
+		sim_run(WAIT_US);
+	else
+		sim_run(TURN_US + (brkAnswer ? BRK_MAB_US : 0) + most*SLOT_US);
+	return most;
+}
+
+
+// UIDs 7FF0:'first', then every 'step' (0: spread out by a random walk)
+static void rig(int count, unsigned long first, unsigned long step)
+{
+	unsigned char uid[RDM_UID_LEN];
+	unsigned long id = first, seed = 12345;
+	int k;
+
+	respCount = count;
+	for(k=0;k<count;k++)
+	{
+		rdm_uidSet(uid, ((unsigned long long)RDM_MANUF << 32) | id);
+		rdmresp_init(&resp[k], uid, 1+k*3, 3);
+		seed = seed*1103515245UL + 12345;
+		id += step ? step : (seed >> 8) % 100000000UL + 1;
+	}
+}
+
+
+static int isResponder(const unsigned char uid[])
+{
+	int k;
+
+	for(k=0;k<respCount;k++)
+		if(!memcmp(resp[k].uid, uid, RDM_UID_LEN))
+			return 1;
+	return 0;
+}
+
+
+// Discover the rig; every responder once
+static unsigned int discover(const char *name)
+{
+	unsigned int i, steps = 0, errors = 0;
+	int k;
+
+	rdmctl_start();
+	while(rdmctl_step() == RDMCTL_BUSY && steps < 20000)
+		steps++;
+	if(rdmctl_count() != respCount)
+	{
+		printf("%s: %u found, %d there\n", name, rdmctl_count(), respCount);
+		errors++;
+	}
+	for(i=0;i<rdmctl_count() && i<RDMCTL_DEVS;i++)
+	{
+		if(!isResponder(rdmctl_uid(i)) || (i && !memcmp(rdmctl_uid(i), rdmctl_uid(i-1), RDM_UID_LEN)))
+		{
+			printf("%s: found %u is wrong\n", name, i+1);
+			errors++;
+		}
+	}
+	for(k=0;k<respCount;k++)
+	{
+		if(!resp[k].muted)
+		{
+			printf("%s: responder %d not muted\n", name, k);
+			errors++;
+		}
+	}
+	printf("%-22s %2u Devices, %4u requests, %5lu ms\n", name, rdmctl_count(), rdmctl_xfers(), rdmctl_busUs()/1000);
+	return errors;
+}
+
+
+int main()
+{
+	const char *rigName[RIGS] = {"nobody", "one", "two next to each other", "eight in a row", "32 spread out", "40 spread out"};
+	const int rigCount[RIGS] = {0, 1, 2, 8, 32, 40};
+	const unsigned long rigStep[RIGS] = {1, 1, 1, 1, 0, 0};
+	unsigned char pd[RDM_PD_MAX], pkt[RDM_PKT_MAX], out[RDM_PKT_MAX], none[RDM_UID_LEN];
+	unsigned int pdl, n, errors = 0;
+	int r, k, brk;
+	const unsigned char *uid;
+
+	sim_init();
+	tb_init();
+	rdmctl_init(bus, myUid);
+
+	for(r=0;r<RIGS;r++)
+	{
+		rig(rigCount[r], 1, rigStep[r]);
+		errors += discover(rigName[r]);
+	}
+
+	rig(8, 1, 1);					// Requests to a found Device
+	discover("requests");
+	uid = rdmctl_uid(2);
+	for(k=0;k<respCount && memcmp(resp[k].uid, uid, RDM_UID_LEN);k++);
+
+	if(rdmctl_get(uid, RDM_PID_DEVINFO, pd, &pdl) != RDMCTL_OK || pdl != RDM_DEVINFO_LEN
+			|| ((pd[10] << 8) | pd[11]) != 3 || ((pd[14] << 8) | pd[15]) != resp[k].address)
+	{
+		printf("DEVICE_INFO: %u bytes, footprint %u, address %u\n", pdl, (pd[10] << 8) | pd[11], (pd[14] << 8) | pd[15]);
+		errors++;
+	}
+
+	pd[0] = 0;						// Start address 100
+	pd[1] = 100;
+	if(rdmctl_set(uid, RDM_PID_ADDR, pd, 2) != RDMCTL_OK || resp[k].address != 100 || !resp[k].addrSet
+			|| rdmctl_get(uid, RDM_PID_ADDR, pd, &pdl) != RDMCTL_OK || pdl != 2 || pd[1] != 100)
+	{
+		printf("DMX_START_ADDRESS: not set to 100\n");
+		errors++;
+	}
+	pd[0] = 2;						// 511: footprint of 3 doesn't fit
+	pd[1] = 0xFF;
+	if(rdmctl_set(uid, RDM_PID_ADDR, pd, 2) != RDMCTL_NACK || rdmctl_nack() != RDM_NR_RANGE || resp[k].address != 100)
+	{
+		printf("DMX_START_ADDRESS: 511 not refused\n");
+		errors++;
+	}
+
+	pd[0] = 1;
+	if(rdmctl_set(uid, RDM_PID_IDENTIFY, pd, 1) != RDMCTL_OK || !resp[k].identify
+			|| rdmctl_get(uid, RDM_PID_IDENTIFY, pd, &pdl) != RDMCTL_OK || pdl != 1 || pd[0] != 1)
+	{
+		printf("IDENTIFY_DEVICE: not on\n");
+		errors++;
+	}
+	for(r=0;r<respCount;r++)
+		resp[r].identify = 1;
+	pd[0] = 0;						// Broadcast: everyone, nobody answers
+	if(rdmctl_set(allUid, RDM_PID_IDENTIFY, pd, 1) != RDMCTL_OK || answers)
+	{
+		printf("broadcast: %u answers\n", answers);
+		errors++;
+	}
+	for(r=0;r<respCount;r++)
+	{
+		if(resp[r].identify)
+		{
+			printf("broadcast: responder %d still identifies\n", r);
+			errors++;
+		}
+	}
+
+	if(rdmctl_get(uid, 0x0080, pd, &pdl) != RDMCTL_NACK || rdmctl_nack() != RDM_NR_UNKNOWN_PID)
+	{
+		printf("unknown PID: no NACK\n");
+		errors++;
+	}
+
+	rdm_uidSet(none, ((unsigned long long)RDM_MANUF << 32) | 999);
+	if(rdmctl_get(none, RDM_PID_DEVINFO, pd, &pdl) != RDMCTL_NOREPLY)
+	{
+		printf("missing Device: answered\n");
+		errors++;
+	}
+
+	n = rdm_build(pkt, uid, myUid, 1, 1, RDM_GET, RDM_PID_DEVINFO, 0, 0);
+	pkt[RDM_TN] ^= 0x10;			// Spoilt on the wire
+	if(rdmresp_handle(&resp[k], pkt, n, out, &brk))
+	{
+		printf("spoilt checksum: answered\n");
+		errors++;
+	}
+
+	printf(errors ? "FAILED\n" : "OK\n");
+	return errors != 0;
+}
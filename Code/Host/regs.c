@@ -0,0 +1,85 @@
+/*! \file regs.c \brief Host image of the dsPIC33FJ128MC802 registers. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'regs.c'
+// Title		: Register storage for the host build
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//*****************************************************************************
+
+#include <p33FJ128MC802.h>
+
+
+// CPU
+volatile SRSFR sfrSR;
+
+// Interrupts
+volatile IFS0SFR sfrIFS0;
+volatile IEC0SFR sfrIEC0;
+volatile IFS1SFR sfrIFS1;
+volatile IEC1SFR sfrIEC1;
+
+// Oscillator
+volatile PLLFBDSFR sfrPLLFBD;
+volatile CLKDIVSFR sfrCLKDIV;
+
+// Port A, analog pins and Change Notification
+volatile TRISASFR sfrTRISA = {0x001F};
+volatile PORTASFR sfrPORTA;
+volatile AD1PCFGLSFR sfrAD1PCFGL;
+volatile CNPU1SFR sfrCNPU1;
+volatile CNPU2SFR sfrCNPU2;
+volatile CNEN1SFR sfrCNEN1;
+volatile CNEN2SFR sfrCNEN2;
+
+// Port B and PPS
+volatile LATBSFR sfrLATB;
+volatile TRISBSFR sfrTRISB = {0xFFFF};
+volatile PORTBSFR sfrPORTB;
+volatile RPOR0SFR sfrRPOR0;
+volatile RPOR1SFR sfrRPOR1;
+volatile RPOR3SFR sfrRPOR3;
+volatile RPOR5SFR sfrRPOR5;
+volatile RPINR7SFR sfrRPINR7;
+volatile RPINR18SFR sfrRPINR18;
+volatile RPINR19SFR sfrRPINR19;
+
+// Timer1 to Timer5
+volatile T1CONSFR sfrT1CON;
+volatile T2CONSFR sfrT2CON;
+volatile T3CONSFR sfrT3CON;
+volatile T4CONSFR sfrT4CON;
+volatile T5CONSFR sfrT5CON;
+volatile unsigned int TMR1, TMR2, TMR3, TMR4, TMR5;
+volatile unsigned int PR1 = 0xFFFF, PR2 = 0xFFFF, PR3 = 0xFFFF, PR4 = 0xFFFF, PR5 = 0xFFFF;
+
+// Input capture 1 (IC1BUF is in sim.c)
+volatile IC1CONSFR sfrIC1CON;
+
+// Output compare 1 to 4
+volatile OC1CONSFR sfrOC1CON;
+volatile OC2CONSFR sfrOC2CON;
+volatile OC3CONSFR sfrOC3CON;
+volatile OC4CONSFR sfrOC4CON;
+volatile unsigned int OC1R, OC2R, OC3R, OC4R;
+volatile unsigned int OC1RS, OC2RS, OC3RS, OC4RS;
+
+// UART1 and UART2 (UxTXREG and UxRXREG are in sim.c)
+volatile U1MODESFR sfrU1MODE;
+volatile U1STASFR sfrU1STA;
+volatile U2MODESFR sfrU2MODE;
+volatile U2STASFR sfrU2STA;
+volatile unsigned int U1BRG, U2BRG;
+
+// DMA0
+volatile DMA0CONSFR sfrDMA0CON;
+volatile DMA0REQSFR sfrDMA0REQ;
+volatile unsigned int DMA0STA;
+volatile unsigned int DMA0STB;
+volatile unsigned int DMA0PAD;
+volatile unsigned int DMA0CNT;
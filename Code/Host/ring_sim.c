@@ -0,0 +1,124 @@
+/*! \file ring_sim.c \brief Runs the ring buffer on the host. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'ring_sim.c'
+// Title		: Ring buffer on the host
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// Goes through the write modes, the pending block calls and the statistics
+// of 'ring.c'. The 'kick' function plays the consumer interrupt so a
+// blocking write can finish. Exit code is non zero on a mismatch.
+//*****************************************************************************
+
+#include <stdio.h>
+#include <string.h>
+#include "ring.h"
+
+
+#define SIZE 16
+
+
+RING ring;
+unsigned char buf[SIZE];
+unsigned char out[256];				// What the consumer got
+unsigned int outLen;
+unsigned int errors;
+
+
+// Consumer interrupt: takes up to 4 bytes (a UART FIFO) every time
+static void kick(void)
+{
+	int i, data;
+
+	for(i=0;i<4;i++)
+	{
+		data = ring_get(&ring);
+		if(data < 0)
+			break;
+		out[outLen++] = data;
+	}
+}
+
+
+static void drain(void)
+{
+	int data;
+
+	while((data = ring_get(&ring)) >= 0)
+		out[outLen++] = data;
+}
+
+
+static void check(int ok, const char *what)
+{
+	if(!ok)
+	{
+		printf("%s: wrong\n", what);
+		errors++;
+	}
+}
+
+
+int main()
+{
+	const unsigned char *text = (const unsigned char *)"The quick brown fox jumps over the lazy dog";
+	unsigned int len = strlen((const char *)text);
+
+	// Non blocking: what fits goes in, the rest is counted
+	ring_init(&ring, buf, SIZE, 0);
+	outLen = 0;
+	check(ring_write(&ring, text, len, RING_NOBLOCK) == SIZE-1, "noblock count");
+	check(ring.drops == len-(SIZE-1) && ring.highWater == SIZE-1, "noblock stats");
+	drain();
+	check(outLen == SIZE-1 && !memcmp(out, text, SIZE-1), "noblock data");
+
+	// Try: all or nothing, no drops
+	ring_init(&ring, buf, SIZE, 0);
+	check(ring_write(&ring, text, len, RING_TRY) == 0 && ring_count(&ring) == 0 && ring.drops == 0, "try too long");
+	check(ring_write(&ring, text, 10, RING_TRY) == 10 && ring_count(&ring) == 10, "try fits");
+
+	// Blocking: the consumer keeps up through 'kick', everything arrives in order
+	ring_init(&ring, buf, SIZE, kick);
+	outLen = 0;
+	check(ring_write(&ring, text, len, RING_BLOCK) == len, "block count");
+	drain();
+	check(outLen == len && !memcmp(out, text, len) && ring.drops == 0, "block data");
+
+	// Pending block: nothing visible until published, backspace, header poke
+	ring_init(&ring, buf, SIZE, 0);
+	ring_pend(&ring, 0);
+	ring_pend(&ring, 'a');
+	ring_pend(&ring, 'x');
+	ring_unpend(&ring);
+	ring_pend(&ring, 'b');
+	check(ring_count(&ring) == 0 && ring_pending(&ring) == 3, "pending hidden");
+	ring_poke(&ring, 0, 2);
+	ring_publish(&ring);
+	outLen = 0;
+	drain();
+	check(outLen == 3 && out[0] == 2 && out[1] == 'a' && out[2] == 'b', "pending published");
+	ring_pend(&ring, 'z');
+	ring_discard(&ring);
+	check(ring_count(&ring) == 0 && ring_pending(&ring) == 0, "pending discarded");
+
+	// Wrap around many times
+	ring_init(&ring, buf, SIZE, 0);
+	for(outLen=0,len=0;len<200;len++)
+	{
+		ring_put(&ring, len, RING_NOBLOCK);
+		if(len % 3 == 2)
+			drain();
+	}
+	drain();
+	for(len=0;len<200 && out[len] == len;len++);
+	check(len == 200 && outLen == 200, "wrap");
+
+	printf(errors ? "FAILED\n" : "ring: modes, pending blocks and statistics\nOK\n");
+	return errors != 0;
+}
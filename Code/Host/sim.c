@@ -0,0 +1,955 @@
+/*! \file sim.c \brief Host model of the dsPIC peripherals. */
+//*****************************************************************************
+// Main Author: agent
+//-----------------------------------------------------------------------------
+// Objectives and notes
+//-----------------------------------------------------------------------------
+// File Name	: 'sim.c'
+// Title		: Peripheral model for the host build
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//
+// Time moves in 1us steps, but every deadline is kept in instruction cycles
+// so odd baud rates (e.g. BAUD_96153) come out right.
+//
+// UART1 and UART2 Tx: 4 deep FIFO in front of the shift register. A byte
+// written to UxTXREG goes into the FIFO on the next write, or on the next
+// step. Every byte that leaves the UART2 shift register goes into the wire
+// log, every one from UART1 into the PC log.
+//
+// DMA0: one-shot, RAM to peripheral. A transfer happens on FORCE and on every
+// UART2 Tx request (a byte moved from the FIFO into the shift register).
+//
+// RB6 carries U2TX while RP6R selects it, otherwise LATB6. A low level on the
+// port latch goes into the wire log as a Break, with its length and the MAB
+// up to the next start bit.
+//
+// RB7 is the receive line. The test sets its level with sim_rxSet(); while
+// RPINR7 routes RP7 to IC1 and IC1 captures every edge (ICM = 001), each
+// change puts the selected timer into a 4 deep capture FIFO and sets IC1IF.
+//
+// UART2 Rx: sim_rxByte() queues bytes (or SIM_BREAK) for the receiver. They
+// come in one character time apart (a Break takes BRK_RX_US) into a 4 deep
+// FIFO, which sets U2RXIF on every byte (URXISEL = 00). A Break comes in as
+// a 0 with FERR, a byte OR'ed with SIM_FERR as that byte with FERR. A byte
+// coming to a full FIFO sets OERR and is lost, like
+// everything after it until the firmware clears OERR (which empties the
+// FIFO). The Rx bytes don't move RB7; sim_rxSet() is separate.
+// UART1 Rx works the same way, fed by sim_pcByte().
+//
+// RS485 bus (see 'bus.c'): sim_busOut() gives the level this node drives,
+// or -1 while its driver is off (RB8 low). sim_busIn() gives it the level
+// on the bus for the next step. That level goes to RB7 and to a bit level
+// UART2 receiver: a falling edge starts a character, every bit is sampled
+// in its middle at the node's own baud rate, and a low stop bit gives
+// FERR. A Break is therefore a 0 with FERR, and the receiver waits for the
+// line to go high again. While the node drives the bus its own receiver
+// is off (DE and /RE are tied) and sees the line idle.
+// sim_busRun() runs a number of steps in one call, with the level heard
+// and driven in each of them, so the firmware keeps running in between.
+//
+// Change Notification: a change on an enabled CN pin of PORTA or PORTB (set
+// by the test) sets CNIF.
+//
+// Firmware with a main loop runs as a coroutine next to the test:
+// sim_fwStart() sets it up, sim_fwRun() lets it run for a while. Its busy
+// waits (hal_spin(), wait_us()) end up in sim_spin(), which moves the model
+// on by 1us and hands control back once the time is up. Idle() sleeps: the
+// firmware is only resumed after an interrupt ran. The firmware's own
+// instructions take no time. The stack is set up with makecontext() once;
+// after that _setjmp()/_longjmp() switch, which costs no system call.
+//*****************************************************************************
+
+#undef _FORTIFY_SOURCE				// Its longjmp() refuses to change stacks
+#include <p33FJ128MC802.h>
+#include <string.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <ucontext.h>
+#include "sim.h"
+
+
+#define CYC_PER_US (FCY/1000000UL)
+#define TX_FIFO 4
+#define WIRE_LOG 4096
+#define PC_LOG 16384
+#define DMA_REGIONS 8
+#define DMA_REGION 0x400
+#define RP_U2TX 5
+#define RP_U2RX 7
+#define IC_FIFO 4
+#define RX_FIFO 4
+#define RX_QUEUE 4096
+#define BRK_RX_US 100				// Break and MAB of a byte queued as SIM_BREAK
+#define FW_STACK 0x10000			// Firmware coroutine stack
+
+
+// Interrupt service routines of the firmware (if linked in)
+extern void _IC1Interrupt(void) __attribute__((weak));
+extern void _T1Interrupt(void) __attribute__((weak));
+extern void _DMA0Interrupt(void) __attribute__((weak));
+extern void _T2Interrupt(void) __attribute__((weak));
+extern void _T3Interrupt(void) __attribute__((weak));
+extern void _U1RXInterrupt(void) __attribute__((weak));
+extern void _U1TXInterrupt(void) __attribute__((weak));
+extern void _T4Interrupt(void) __attribute__((weak));
+extern void _CNInterrupt(void) __attribute__((weak));
+extern void _U2RXInterrupt(void) __attribute__((weak));
+extern void _U2TXInterrupt(void) __attribute__((weak));
+
+
+// Model time
+unsigned long simUs;
+unsigned long long simCyc;
+
+// UART1 and UART2
+typedef struct
+{
+	volatile UxMODEBITS *mode;
+	volatile UxSTABITS *sta;
+	volatile unsigned int *brg;
+	volatile unsigned int *ifs;		// IFSx word with the flags below
+	unsigned int txIf, rxIf;
+
+	// Tx
+	volatile unsigned int txReg;	// UxTXREG, 0xFFFF once it is in the FIFO
+	unsigned char txFifo[TX_FIFO];
+	int txCount;
+	int txShifting;					// Shift register busy
+	unsigned char txShift;
+	unsigned long long txStart;		// Cycle its start bit began
+	unsigned long long txDone;		// Cycle the shift register gets empty
+
+	// Rx
+	unsigned int rcvHead, rcvTail;
+	unsigned long long rcvNext;		// Cycle the next byte is complete
+	unsigned int rcvFifo[RX_FIFO];	// Received, as queued
+	int rcvCount;
+	int rcvOverrun;
+	struct
+	{
+		unsigned int data;			// Byte, SIM_BREAK or SIM_FERR | byte
+		unsigned long long done;	// Cycle it is completely received
+	} rcvQueue[RX_QUEUE];			// Still on the way (last, it is big)
+} SIM_UART;
+
+SIM_UART uart1 = {&U1MODEbits, &U1STAbits, &U1BRG, &IFS0, 1 << 12, 1 << 11};
+SIM_UART uart2 = {&U2MODEbits, &U2STAbits, &U2BRG, &IFS1, 1 << 15, 1 << 14};
+
+// Timer1 to Timer5 (16 bit mode)
+typedef struct
+{
+	volatile TxCONBITS *con;
+	volatile unsigned int *tmr;
+	volatile unsigned int *pr;
+	unsigned long cyc;				// Cycles not yet counted by the prescaler
+} SIM_TIMER;
+
+SIM_TIMER timer[5] = {
+	{&T1CONbits, &TMR1, &PR1},
+	{&T2CONbits, &TMR2, &PR2},
+	{&T3CONbits, &TMR3, &PR3},
+	{&T4CONbits, &TMR4, &PR4},
+	{&T5CONbits, &TMR5, &PR5},
+};
+
+// Change Notification pins: CN number, port (0 = A, 1 = B) and bit
+const unsigned char cnPin[][3] = {
+	{0, 0, 4}, {1, 1, 4}, {2, 0, 0}, {3, 0, 1}, {4, 1, 0}, {5, 1, 1}, {6, 1, 2},
+	{7, 1, 3}, {11, 1, 15}, {12, 1, 14}, {13, 1, 13}, {14, 1, 12}, {15, 1, 11},
+	{16, 1, 10}, {21, 1, 9}, {22, 1, 8}, {23, 1, 7}, {24, 1, 6}, {27, 1, 5},
+	{29, 0, 3}, {30, 0, 2},
+};
+unsigned int cnLast[2];				// PORTA and PORTB at the last step
+
+// Break on RB6
+int brkLow;
+unsigned long long brkStart, brkEnd;
+int brkMabOpen;						// Last wire entry is a Break still waiting for its MAB
+
+// IC1 on RB7
+unsigned int icFifo[IC_FIFO];
+int icCount;
+
+// DMA0
+unsigned int dmaIndex;				// Transfers done in this block
+int dmaWasOn;
+const void *dmaBase[DMA_REGIONS];	// Buffers handed out by __builtin_dmaoffset()
+
+// RS485 wire
+SIM_WIRE wire[WIRE_LOG];
+unsigned int wireCount;
+
+// PC side of UART1
+unsigned char pcLog[PC_LOG];
+unsigned int pcCount;
+
+// RS485 bus, UART2 bit level receiver
+int busLevel = 1;					// Line as the receiver sees it
+int busLast = 1;					// and one step before
+int rxBit = -1;						// Bits of the character sampled, -1 while idle
+unsigned int rxData;
+unsigned long long rxSample;		// Cycle of the next sample
+const signed char *busHear;			// sim_busRun(): levels heard, one per step
+signed char *busDrive;				// and driven
+
+// Firmware coroutine
+ucontext_t fwCtx, testCtx;
+jmp_buf fwJmp, testJmp;
+char *fwStack;
+int (*fwMain)(void);
+int fwStarted;						// Has run on its own stack
+int fwIn;							// Running on the firmware's stack
+int fwIdle;							// In Idle(), waits for an interrupt
+int fwDone;							// Its main() returned
+unsigned long fwUntil;				// Model time it hands back at
+unsigned long isrCount;				// Interrupt routines run
+
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// __builtin_dmaoffset() for the host. Each buffer gets its own 1K region.
+unsigned int sim_dmaOffset(const void *p)
+{
+	int i;
+
+	for(i=0;i<DMA_REGIONS;i++)
+	{
+		if(dmaBase[i] == p || dmaBase[i] == 0)
+		{
+			dmaBase[i] = p;
+			return i*DMA_REGION;
+		}
+	}
+	return 0;
+}
+
+
+// Address inside DMA RAM for an offset
+void *sim_dmaPtr(unsigned int offset)
+{
+	return (unsigned char *)dmaBase[offset/DMA_REGION] + (offset%DMA_REGION);
+}
+
+
+static unsigned long long uart_bitCyc(SIM_UART *u)
+{
+	return (*u->brg+1) * (u->mode->BRGH ? 4 : 16);
+}
+
+
+// Cycles for one character (start + 8 data + stop bits)
+static unsigned long long uart_charCyc(SIM_UART *u)
+{
+	return uart_bitCyc(u) * (u->mode->STSEL ? 11 : 10);
+}
+
+
+static void wire_log(unsigned int data)
+{
+	if(wireCount < WIRE_LOG)
+	{
+		wire[wireCount].us = simUs;
+		wire[wireCount].data = data;
+		wire[wireCount].brkUs = 0;
+		wire[wireCount].mabUs = 0;
+		wireCount++;
+	}
+}
+
+
+// Break and MAB made by driving RB6 from its port latch
+static void pin_step(void)
+{
+	int low = (RPOR3bits.RP6R != RP_U2TX && !TRISBbits.TRISB6 && !LATBbits.LATB6);
+
+	if(low && !brkLow)
+		brkStart = simCyc;
+	else if(!low && brkLow)
+	{
+		brkEnd = simCyc;
+		wire_log(SIM_BREAK);
+		if(wireCount)
+			wire[wireCount-1].brkUs = (brkEnd - brkStart)/CYC_PER_US;
+		brkMabOpen = 1;
+	}
+	brkLow = low;
+}
+
+
+// First start bit after a Break closes the MAB
+static void mab_close(void)
+{
+	if(brkMabOpen && wireCount)
+		wire[wireCount-1].mabUs = (simCyc - brkEnd)/CYC_PER_US;
+	brkMabOpen = 0;
+}
+
+
+// Prescaler 1:1, 1:8, 1:64, 1:256 as a shift
+static unsigned int timer_presc(unsigned int tckps)
+{
+	static const unsigned char shift[4] = {0, 3, 6, 8};
+
+	return shift[tckps & 3];
+}
+
+
+// Count 'ticks' on a timer. Returns 1 if it matched its period register.
+static int timer_count(volatile unsigned int *tmr, unsigned int pr, unsigned long ticks)
+{
+	int match = 0;
+
+	while(ticks)
+	{
+		unsigned long left = (unsigned long)(pr - *tmr);
+
+		if(ticks <= left)
+		{
+			*tmr += ticks;
+			break;
+		}
+		ticks -= left + 1;			// TMR == PR, next tick clears it
+		*tmr = 0;
+		match = 1;
+	}
+	return match;
+}
+
+
+// Timer1 to Timer5. Returns a bit mask of the timers which matched PRx.
+static int timer_step(void)
+{
+	int i, match = 0;
+	unsigned int presc;
+	SIM_TIMER *t;
+
+	for(i=0;i<5;i++)
+	{
+		t = &timer[i];
+		if(!t->con->TON)
+		{
+			t->cyc = 0;
+			continue;
+		}
+		presc = timer_presc(t->con->TCKPS);
+		t->cyc += CYC_PER_US;
+		if(timer_count(t->tmr, *t->pr, t->cyc >> presc))
+			match |= 1 << i;
+		t->cyc &= (1UL << presc) - 1;
+	}
+	return match;
+}
+
+
+static void timers_step(void)
+{
+	int match = timer_step();
+
+	if(match & 1) IFS0bits.T1IF = 1;
+	if(match & 2) IFS0bits.T2IF = 1;
+	if(match & 4) IFS0bits.T3IF = 1;
+	if(match & 8) IFS1bits.T4IF = 1;
+	if(match & 16) IFS1bits.T5IF = 1;
+}
+
+
+// A change on an enabled CN pin sets CNIF
+static void cn_step(void)
+{
+	unsigned int port[2] = {PORTA, PORTB};
+	unsigned long en = CNEN1 | ((unsigned long)CNEN2 << 16);
+	unsigned int i;
+
+	if(port[0] == cnLast[0] && port[1] == cnLast[1])
+		return;
+	for(i=0;i<sizeof(cnPin)/sizeof(cnPin[0]);i++)
+	{
+		if(((en >> cnPin[i][0]) & 1) && (((port[cnPin[i][1]] ^ cnLast[cnPin[i][1]]) >> cnPin[i][2]) & 1))
+			IFS1bits.CNIF = 1;
+	}
+	cnLast[0] = port[0];
+	cnLast[1] = port[1];
+}
+
+
+static void uart_push(SIM_UART *u, unsigned char data)
+{
+	if(u->txCount < TX_FIFO)
+		u->txFifo[u->txCount++] = data;
+}
+
+
+// Byte the CPU wrote into UxTXREG goes into the FIFO
+static void uart_take(SIM_UART *u)
+{
+	if(u->txReg != 0xFFFF)
+	{
+		uart_push(u, u->txReg);
+		u->txReg = 0xFFFF;
+	}
+}
+
+
+// UxTXREG for the host. The firmware is about to write it, so the status
+// already counts the byte.
+static volatile unsigned int *uart_txReg(SIM_UART *u)
+{
+	uart_take(u);
+	u->sta->UTXBF = (u->txCount >= TX_FIFO-1);
+	u->sta->TRMT = 0;
+	return &u->txReg;
+}
+
+
+volatile unsigned int *sim_u1txReg(void)
+{
+	return uart_txReg(&uart1);
+}
+
+
+volatile unsigned int *sim_u2txReg(void)
+{
+	return uart_txReg(&uart2);
+}
+
+
+// One DMA0 transfer into U2TXREG
+static void dma0_transfer(void)
+{
+	unsigned char *p = sim_dmaPtr(DMA0STA);
+
+	uart_push(&uart2, p[dmaIndex++]);
+	if(dmaIndex > DMA0CNT)			// Block done
+	{
+		dmaIndex = 0;
+		DMA0CONbits.CHEN = 0;		// One-shot
+		IFS0bits.DMA0IF = 1;
+	}
+}
+
+
+static void dma0_request(void)
+{
+	if(DMA0CONbits.CHEN && DMA0REQbits.IRQSEL == 0x1F)
+		dma0_transfer();
+}
+
+
+static void dma0_step(void)
+{
+	if(DMA0CONbits.CHEN && !dmaWasOn)
+		dmaIndex = 0;
+	dmaWasOn = DMA0CONbits.CHEN;
+	if(DMA0REQbits.FORCE)
+	{
+		DMA0REQbits.FORCE = 0;
+		if(DMA0CONbits.CHEN)
+			dma0_transfer();
+	}
+}
+
+
+// Byte left the shift register
+static void uart_sent(SIM_UART *u, unsigned char data)
+{
+	if(u == &uart2)
+	{
+		if(RPOR3bits.RP6R == RP_U2TX)	// Only reaches the bus through the pin
+			wire_log(data);
+	}
+	else if(pcCount < PC_LOG)
+		pcLog[pcCount++] = data;
+}
+
+
+static void uart_txStep(SIM_UART *u)
+{
+	uart_take(u);
+
+	if(u->txShifting && simCyc >= u->txDone)
+	{
+		u->txShifting = 0;
+		uart_sent(u, u->txShift);
+		if(u->txCount == 0 && u->sta->UTXISEL1 == 0 && u->sta->UTXISEL0 == 1)
+			*u->ifs |= u->txIf;		// UTXISEL = 01: all transmit operations done
+	}
+	if(!u->txShifting && u->txCount > 0)	// Load shift register from the FIFO
+	{
+		u->txShift = u->txFifo[0];
+		memmove(u->txFifo, u->txFifo+1, --u->txCount);
+		u->txShifting = 1;
+		u->txStart = simCyc;
+		u->txDone = simCyc + uart_charCyc(u);
+		if(u == &uart2)
+			mab_close();
+		if(u->sta->UTXISEL1 == 0 && u->sta->UTXISEL0 == 0)
+		{
+			*u->ifs |= u->txIf;		// UTXISEL = 00: a FIFO location got free
+			if(u == &uart2)
+				dma0_request();
+		}
+		else if(u->sta->UTXISEL1 == 1 && u->txCount == 0)
+			*u->ifs |= u->txIf;		// UTXISEL = 10: FIFO got empty
+	}
+
+	u->sta->UTXBF = (u->txCount == TX_FIFO);
+	u->sta->TRMT = (u->txCount == 0 && !u->txShifting);
+}
+
+
+// UxRXREG for the host: oldest byte of the FIFO (a Break reads 0)
+static unsigned int uart_rxReg(SIM_UART *u)
+{
+	unsigned int data = u->rcvFifo[0];
+
+	if(!u->rcvCount)
+		return 0;
+	memmove(u->rcvFifo, u->rcvFifo+1, --u->rcvCount * sizeof(u->rcvFifo[0]));
+	u->sta->URXDA = (u->rcvCount != 0);
+	u->sta->FERR = (u->rcvCount && (u->rcvFifo[0] & (SIM_BREAK|SIM_FERR)));
+	return data & 0xFF;
+}
+
+
+unsigned int sim_u1rxReg(void)
+{
+	return uart_rxReg(&uart1);
+}
+
+
+unsigned int sim_u2rxReg(void)
+{
+	return uart_rxReg(&uart2);
+}
+
+
+static void uart_rxQueue(SIM_UART *u, unsigned int data)
+{
+	if(((u->rcvHead+1) % RX_QUEUE) == u->rcvTail)
+		return;
+	if(u->rcvNext < simCyc)
+		u->rcvNext = simCyc;		// Line was idle, starts now
+	u->rcvNext += (data == SIM_BREAK) ? BRK_RX_US*CYC_PER_US : uart_charCyc(u);
+	u->rcvQueue[u->rcvHead].data = data;
+	u->rcvQueue[u->rcvHead].done = u->rcvNext;
+	u->rcvHead = (u->rcvHead+1) % RX_QUEUE;
+}
+
+
+// Queue a byte (or SIM_BREAK) for the UART2 receiver
+void sim_rxByte(unsigned int data)
+{
+	uart_rxQueue(&uart2, data);
+}
+
+
+// Bytes queued by sim_rxByte() and not received yet
+unsigned int sim_rxPending(void)
+{
+	return (uart2.rcvHead + RX_QUEUE - uart2.rcvTail) % RX_QUEUE;
+}
+
+
+// Queue a byte from the PC for the UART1 receiver
+void sim_pcByte(unsigned char data)
+{
+	uart_rxQueue(&uart1, data);
+}
+
+
+// Queue a string from the PC
+void sim_pcString(const char *str)
+{
+	while(*str)
+		uart_rxQueue(&uart1, (unsigned char)*str++);
+}
+
+
+// Bytes queued for UART1 and not received yet
+unsigned int sim_pcPending(void)
+{
+	return (uart1.rcvHead + RX_QUEUE - uart1.rcvTail) % RX_QUEUE;
+}
+
+
+// Character complete, into the receive FIFO
+static void uart_rxPut(SIM_UART *u, unsigned int data)
+{
+	if(u->rcvOverrun || !u->mode->UARTEN)
+		return;
+	if(u->rcvCount == RX_FIFO)
+	{
+		u->rcvOverrun = 1;
+		u->sta->OERR = 1;
+		return;
+	}
+	u->rcvFifo[u->rcvCount++] = data;
+	*u->ifs |= u->rxIf;				// URXISEL = 00: every byte
+}
+
+
+// UART2 receiver on the bus line
+static void uart_rxBit(SIM_UART *u)
+{
+	if(rxBit < 0)
+	{
+		if(busLast && !busLevel)	// Start bit
+		{
+			rxBit = 0;
+			rxData = 0;
+			rxSample = simCyc + uart_bitCyc(u)/2;
+		}
+	}
+	else if(simCyc >= rxSample)
+	{
+		if(rxBit == 0 && busLevel)
+			rxBit = -1;				// Glitch, not a start bit
+		else if(rxBit >= 1 && rxBit <= 8)
+			rxData |= busLevel << (rxBit-1);
+		else if(rxBit == 9)			// First stop bit
+		{
+			uart_rxPut(u, busLevel ? rxData : (rxData | SIM_FERR));
+			rxBit = -1;
+		}
+		if(rxBit >= 0)
+		{
+			rxBit++;
+			rxSample += uart_bitCyc(u);
+		}
+	}
+	busLast = busLevel;
+}
+
+
+static void uart_rxStep(SIM_UART *u)
+{
+	if(u->rcvOverrun && !u->sta->OERR)	// Firmware cleared OERR
+	{
+		u->rcvOverrun = 0;
+		u->rcvCount = 0;
+	}
+
+	while(u->rcvTail != u->rcvHead && u->rcvQueue[u->rcvTail].done <= simCyc)
+	{
+		uart_rxPut(u, u->rcvQueue[u->rcvTail].data);
+		u->rcvTail = (u->rcvTail+1) % RX_QUEUE;
+	}
+	if(u == &uart2)
+		uart_rxBit(u);
+
+	u->sta->URXDA = (u->rcvCount != 0);
+	u->sta->FERR = (u->rcvCount && (u->rcvFifo[0] & (SIM_BREAK|SIM_FERR)));
+	u->sta->RIDLE = (u->rcvTail == u->rcvHead && (u != &uart2 || rxBit < 0));
+}
+
+
+static void uart_reset(SIM_UART *u)
+{
+	u->txReg = 0xFFFF;
+	u->txCount = 0;
+	u->txShifting = 0;
+	u->rcvHead = u->rcvTail = 0;
+	u->rcvNext = 0;
+	u->rcvCount = 0;
+	u->rcvOverrun = 0;
+	u->sta->TRMT = 1;
+	u->sta->RIDLE = 1;
+}
+
+
+// IC1BUF for the host: oldest capture, 0 if there is none
+unsigned int sim_ic1Buf(void)
+{
+	unsigned int t = icFifo[0];
+
+	if(icCount)
+		memmove(icFifo, icFifo+1, --icCount * sizeof(icFifo[0]));
+	IC1CONbits.ICBNE = (icCount != 0);
+	return t;
+}
+
+
+// Drive the receive line (RB7)
+void sim_rxSet(int level)
+{
+	level = (level != 0);
+	if(level == PORTBbits.RB7)
+		return;
+	PORTBbits.RB7 = level;
+	if(IC1CONbits.ICM != 1 || RPINR7bits.IC1R != RP_U2RX)
+		return;
+	if(icCount < IC_FIFO)
+		icFifo[icCount++] = IC1CONbits.ICTMR ? TMR2 : TMR3;
+	else
+		IC1CONbits.ICOV = 1;
+	IC1CONbits.ICBNE = 1;
+	IFS0bits.IC1IF = 1;				// ICI = 00: every capture
+}
+
+
+static void isr(int pending, void (*fn)(void))
+{
+	if(pending && fn)
+	{
+		fn();
+		isrCount++;
+	}
+}
+
+
+static void isr_step(void)
+{
+	if(SRbits.IPL >= 4)				// Every source runs at the default priority 4
+		return;
+	if(!(IFS0 & IEC0) && !(IFS1 & IEC1))
+		return;
+	isr(IFS0bits.IC1IF && IEC0bits.IC1IE, _IC1Interrupt);
+	isr(IFS0bits.T1IF && IEC0bits.T1IE, _T1Interrupt);
+	isr(IFS0bits.DMA0IF && IEC0bits.DMA0IE, _DMA0Interrupt);
+	isr(IFS0bits.T2IF && IEC0bits.T2IE, _T2Interrupt);
+	isr(IFS0bits.T3IF && IEC0bits.T3IE, _T3Interrupt);
+	isr(IFS0bits.U1RXIF && IEC0bits.U1RXIE, _U1RXInterrupt);
+	isr(IFS0bits.U1TXIF && IEC0bits.U1TXIE, _U1TXInterrupt);
+	isr(IFS1bits.CNIF && IEC1bits.CNIE, _CNInterrupt);
+	isr(IFS1bits.T4IF && IEC1bits.T4IE, _T4Interrupt);
+	isr(IFS1bits.U2TXIF && IEC1bits.U2TXIE, _U2TXInterrupt);
+	isr(IFS1bits.U2RXIF && IEC1bits.U2RXIE, _U2RXInterrupt);
+}
+
+
+// Reset the model
+void sim_init(void)
+{
+	int i;
+
+	simUs = 0;
+	simCyc = 0;
+	uart_reset(&uart1);
+	uart_reset(&uart2);
+	dmaIndex = 0;
+	dmaWasOn = 0;
+	for(i=0;i<5;i++)
+		timer[i].cyc = 0;
+	brkLow = 0;
+	brkMabOpen = 0;
+	icCount = 0;
+	PORTBbits.RB7 = 1;				// Receive line idles high
+	cnLast[0] = PORTA;
+	cnLast[1] = PORTB;
+	wireCount = 0;
+	pcCount = 0;
+	busLevel = busLast = 1;
+	rxBit = -1;
+	RPOR3bits.RP6R = RP_U2TX;
+}
+
+
+// Advance the model by 'us' microseconds
+void sim_run(unsigned long us)
+{
+	while(us--)
+	{
+		if(busHear)					// sim_busRun(): bus level of this step
+		{
+			*busDrive++ = sim_busOut();
+			sim_busIn(*busHear++);
+		}
+		pin_step();
+		dma0_step();
+		uart_txStep(&uart2);
+		uart_rxStep(&uart2);
+		uart_txStep(&uart1);
+		uart_rxStep(&uart1);
+		timers_step();
+		cn_step();
+		isr_step();
+		simUs++;
+		simCyc += CYC_PER_US;
+	}
+}
+
+
+unsigned long sim_now(void)
+{
+	return simUs;
+}
+
+
+unsigned int sim_wireCount(void)
+{
+	return wireCount;
+}
+
+
+const SIM_WIRE *sim_wire(void)
+{
+	return wire;
+}
+
+
+void sim_wireClear(void)
+{
+	wireCount = 0;
+}
+
+
+unsigned int sim_pcCount(void)
+{
+	return pcCount;
+}
+
+
+// What UART1 sent to the PC (not 0 terminated)
+const unsigned char *sim_pc(void)
+{
+	return pcLog;
+}
+
+
+void sim_pcClear(void)
+{
+	pcCount = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// RS485 bus
+//-----------------------------------------------------------------------------
+
+// Level this node drives onto the bus, -1 while its driver is off
+int sim_busOut(void)
+{
+	SIM_UART *u = &uart2;
+	unsigned long long bit;
+
+	if(TRISBbits.TRISB8 || !LATBbits.LATB8)
+		return -1;
+	if(RPOR3bits.RP6R != RP_U2TX)	// Port latch, e.g. a Break
+		return TRISBbits.TRISB6 || LATBbits.LATB6;
+	if(!u->txShifting)
+		return 1;
+	bit = (simCyc - u->txStart) / uart_bitCyc(u);
+	if(bit == 0)
+		return 0;					// Start bit
+	if(bit <= 8)
+		return (u->txShift >> (bit-1)) & 1;
+	return 1;						// Stop bits
+}
+
+
+// Level on the bus for the next step
+void sim_busIn(int level)
+{
+	if(!TRISBbits.TRISB8 && LATBbits.LATB8)
+		level = 1;					// Receiver is off while we drive
+	busLevel = level;
+	sim_rxSet(level);
+}
+
+
+// 'us' steps on the bus in one go: out[] gets the level driven in each,
+// in[] has the level heard in each
+void sim_busRun(const signed char in[], signed char out[], unsigned int us)
+{
+	busHear = in;
+	busDrive = out;
+	sim_fwRun(us);
+	busHear = 0;
+	busDrive = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Firmware coroutine
+//-----------------------------------------------------------------------------
+
+// Back to sim_fwRun(), until it resumes us
+static void fw_yield(void)
+{
+	fwIn = 0;
+	if(!_setjmp(fwJmp))
+		_longjmp(testJmp, 1);
+	fwIn = 1;
+}
+
+
+static void fw_entry(void)
+{
+	fwMain();
+	fwDone = 1;
+	fwIn = 0;
+	_longjmp(testJmp, 1);
+}
+
+
+// Firmware main() runs from the first sim_fwRun() on
+void sim_fwStart(int (*entry)(void))
+{
+	if(!fwStack)
+		fwStack = malloc(FW_STACK);
+	fwMain = entry;
+	fwStarted = 0;
+	fwIdle = 0;
+	fwDone = 0;
+	getcontext(&fwCtx);
+	fwCtx.uc_stack.ss_sp = fwStack;
+	fwCtx.uc_stack.ss_size = FW_STACK;
+	fwCtx.uc_link = 0;
+	makecontext(&fwCtx, fw_entry, 0);
+}
+
+
+// Let the firmware and the model run for 'us' microseconds
+void sim_fwRun(unsigned long us)
+{
+	unsigned long isrs;
+
+	fwUntil = simUs + us;
+	while(simUs < fwUntil)
+	{
+		if(fwDone || !fwMain)
+			sim_run(fwUntil - simUs);
+		else if(fwIdle)				// Asleep: only the peripherals run
+		{
+			isrs = isrCount;
+			sim_run(1);
+			if(isrCount != isrs)
+				fwIdle = 0;
+		}
+		else if(!_setjmp(testJmp))
+		{
+			fwIn = 1;
+			if(fwStarted)
+				_longjmp(fwJmp, 1);
+			fwStarted = 1;
+			swapcontext(&testCtx, &fwCtx);
+		}
+	}
+}
+
+
+// Busy wait of the firmware: 1us of model time
+void sim_spin(void)
+{
+	sim_run(1);
+	if(fwIn && simUs >= fwUntil)
+		fw_yield();
+}
+
+
+// Idle(): sleep up to the next interrupt
+void sim_idle(void)
+{
+	if(!fwIn)
+	{
+		sim_run(1);
+		return;
+	}
+	fwIdle = 1;
+	fw_yield();
+}
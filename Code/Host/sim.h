@@ -0,0 +1,63 @@
+/*! \file sim.h \brief Host model of the dsPIC peripherals. */
+//*****************************************************************************
+//
+// File Name	: 'sim.h'
+// Title		: Peripheral model for the host build
+// Author		: agent - Copyright (C) 2026
+// Created		: 17th October, 2026
+// Revised		:
+// Version		: 1.0
+// Target		: Linux host (gcc)
+//*****************************************************************************
+
+#ifndef __SIM_H__
+ #define __SIM_H__
+
+
+#define FCY 40000000UL				// Instruction clock of the target
+#define SIM_BREAK 0x100				// Wire log entry for a Break
+#define SIM_FERR 0x200				// sim_rxByte(): OR'ed to a byte whose stop bit is missing
+
+
+// One entry of the RS485 wire log
+typedef struct
+{
+	unsigned long us;				// Time the byte was completely on the wire
+	unsigned int data;				// Byte, or SIM_BREAK
+	unsigned int brkUs;				// Break: its length
+	unsigned int mabUs;				// Break: MAB up to the next start bit
+} SIM_WIRE;
+
+
+//Functions
+void sim_init(void);
+void sim_run(unsigned long us);
+unsigned long sim_now(void);
+
+unsigned int sim_wireCount(void);
+const SIM_WIRE *sim_wire(void);
+void sim_wireClear(void);
+
+void sim_rxSet(int level);
+void sim_rxByte(unsigned int data);
+unsigned int sim_rxPending(void);
+
+void sim_pcByte(unsigned char data);
+void sim_pcString(const char *str);
+unsigned int sim_pcPending(void);
+unsigned int sim_pcCount(void);
+const unsigned char *sim_pc(void);
+void sim_pcClear(void);
+
+void *sim_dmaPtr(unsigned int offset);
+
+int sim_busOut(void);
+void sim_busIn(int level);
+void sim_busRun(const signed char in[], signed char out[], unsigned int us);
+
+void sim_fwStart(int (*entry)(void));
+void sim_fwRun(unsigned long us);
+void sim_spin(void);
+void sim_idle(void);
+
+#endif